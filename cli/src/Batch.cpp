@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "Batch.h"
+#include "Converter.h"
+#include "WorkerPool.h"
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+bool ReadManifest(const std::string& path, std::vector<BatchJob>& jobs)
+{
+  std::ifstream manifest(path);
+  if (!manifest)
+  {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(manifest, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    BatchJob job;
+    auto iTab = line.find('\t');
+    job.inPath = line.substr(0, iTab);
+    if (iTab != std::string::npos)
+    {
+      job.outPath = line.substr(iTab + 1);
+    }
+    jobs.push_back(job);
+  }
+  return true;
+}
+
+unsigned int RunBatch(const std::vector<BatchJob>& jobs, unsigned int numThreads, std::ostream& summary,
+  Cache* cache, const SaveOptions& options)
+{
+  WorkerPool workers(numThreads);
+
+  // Converters are handed out to whichever thread picks up the next job; there's
+  // one for each thread, so one is always available.
+  std::vector<std::unique_ptr<Converter>> converters;
+  std::vector<Converter*> available;
+  for (unsigned int i = 0; i < workers.GetNumThreads(); ++i)
+  {
+    converters.emplace_back(new Converter(nullptr, cache, options));
+    available.push_back(converters.back().get());
+  }
+  std::mutex availableMutex;
+
+  std::vector<ConversionStats> stats(jobs.size());
+  workers.Run(jobs.size(), [&](unsigned int i) {
+    Converter* converter;
+    {
+      std::lock_guard<std::mutex> lock(availableMutex);
+      converter = available.back();
+      available.pop_back();
+    }
+
+    // A failure to convert one job mustn't abort the rest, nor the summary.
+    auto& job = jobs[i];
+    try
+    {
+      converter->ConvertFile(job.inPath, GetOutputBasePath(job.inPath, job.outPath), stats[i]);
+    }
+    catch (const std::exception& e)
+    {
+      stats[i].success = false;
+      stats[i].error = "Failed to convert scene file '" + job.inPath + "': " + e.what();
+    }
+    catch (...)
+    {
+      stats[i].success = false;
+      stats[i].error = "Failed to convert scene file '" + job.inPath + "'.";
+    }
+
+    std::lock_guard<std::mutex> lock(availableMutex);
+    available.push_back(converter);
+  });
+
+  unsigned int numFailed = 0;
+  for (unsigned int i = 0; i < jobs.size(); ++i)
+  {
+    auto& s = stats[i];
+    numFailed += s.success ? 0 : 1;
+    summary << (s.success ? (s.cached ? "CACHED" : "OK") : "FAILED") << '\t' << s.seconds * 1000.0 << '\t' <<
+      s.dliSize << '\t' << s.binSize << '\t' << s.aniSize << '\t' << jobs[i].inPath << '\t' <<
+      s.error << '\n';
+  }
+  summary.flush();
+  return numFailed;
+}
@@ -0,0 +1,52 @@
+#ifndef BATCH_H
+#define BATCH_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "SaveScene.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Cache;
+
+///@brief An input file to convert, and optionally the path of its output.
+struct BatchJob
+{
+  std::string inPath;
+  std::string outPath;  // may be empty; refer to GetOutputBasePath().
+};
+
+///@brief Reads jobs from the manifest file at @a path, and appends them to @a jobs.
+/// Each line is an input path, optionally followed by a tab and an output path.
+/// Empty lines, and ones starting with '#' are skipped.
+///@return Whether the manifest could be read.
+bool ReadManifest(const std::string& path, std::vector<BatchJob>& jobs);
+
+///@brief Converts all @a jobs, on @a numThreads threads, each using its own
+/// Converter across the jobs it picks up. Once all jobs have finished, writes a
+/// line for each of them to @a summary, in order, with the following tab
+/// separated fields: status (OK, CACHED or FAILED), time in milliseconds, size of the
+/// .dli, .bin, and the total size of the animation files in bytes, input path,
+/// and error message (if any).
+///@param cache Optional; refer to Converter.
+///@param options The options that scenes are saved with.
+///@return The number of jobs that have failed.
+unsigned int RunBatch(const std::vector<BatchJob>& jobs, unsigned int numThreads, std::ostream& summary,
+  Cache* cache = nullptr, const SaveOptions& options = SaveOptions());
+
+#endif // BATCH_H
@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "Cache.h"
+#include "Converter.h"
+#include "Hash.h"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <direct.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// NOTE: bump this whenever a change to the exporter changes its output, so that
+// stale entries aren't used.
+const char* const CACHE_VERSION = "dli-exporter-cache 4";
+
+const char* const INDEX_FILE_NAME = "index";
+const char* const LOCK_FILE_NAME = "index.lock";
+const char* const ENTRY_EXTENSION = ".entry";
+
+std::string ToHex(uint64_t value)
+{
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+  return buffer;
+}
+
+std::string GetDirectory(const std::string& path)
+{
+  auto iSeparator = path.find_last_of("\\/");
+  return iSeparator != std::string::npos ? path.substr(0, iSeparator + 1) : "";
+}
+
+std::string GetFileName(const std::string& path)
+{
+  return path.substr(GetDirectory(path).size());
+}
+
+bool IsAbsolute(const std::string& path)
+{
+  return !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+}
+
+bool HashFile(const std::string& path, uint64_t& outHash)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+
+  std::vector<char> buffer(1 << 20);
+  uint64_t hash = 0;
+  uint64_t size = 0;
+  while (file)
+  {
+    file.read(buffer.data(), buffer.size());
+    const auto numRead = file.gcount();
+    hash = Hash64(buffer.data(), numRead, hash);
+    size += numRead;
+  }
+  outHash = Hash64(&size, sizeof(size), hash);
+  return true;
+}
+
+bool CopyFile(const std::string& from, const std::string& to, uint64_t& outSize)
+{
+  std::ifstream source(from, std::ios::binary);
+  std::ofstream target(to, std::ios::binary);
+  if (!source || !target)
+  {
+    return false;
+  }
+
+  if (source.peek() != std::ifstream::traits_type::eof())
+  {
+    target << source.rdbuf();
+  }
+  outSize = target.tellp();
+  return static_cast<bool>(target);
+}
+
+bool WriteFile(const std::string& path, const std::string& contents)
+{
+  std::ofstream file(path, std::ios::binary);
+  file.write(contents.data(), contents.size());
+  return static_cast<bool>(file);
+}
+
+///@brief Replaces @a to with @a from, which is removed.
+bool Rename(const std::string& from, const std::string& to)
+{
+  std::remove(to.c_str());  // rename() doesn't overwrite on all platforms.
+  if (std::rename(from.c_str(), to.c_str()) != 0)
+  {
+    std::remove(from.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string GetAnimationPath(const std::string& entryPath, unsigned int index)
+{
+  return entryPath + '.' + std::to_string(index) + ".ani";
+}
+
+///@brief An exclusive lock of the file at @a path - which is created if it
+/// doesn't exist - across processes, for the lifetime of the object. If the
+/// file can't be opened, no lock is taken.
+class FileLock
+{
+public:
+  explicit FileLock(const std::string& path)
+  {
+#ifdef _WIN32
+    m_Handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+      nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_Handle != INVALID_HANDLE_VALUE)
+    {
+      OVERLAPPED overlapped = {};
+      LockFileEx(m_Handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);
+    }
+#else
+    m_File = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+    if (m_File != -1)
+    {
+      while (flock(m_File, LOCK_EX) != 0 && errno == EINTR)
+      {}
+    }
+#endif
+  }
+
+  ~FileLock()
+  {
+    // Closing the file releases the lock.
+#ifdef _WIN32
+    if (m_Handle != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(m_Handle);
+    }
+#else
+    if (m_File != -1)
+    {
+      close(m_File);
+    }
+#endif
+  }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+private:
+#ifdef _WIN32
+  HANDLE m_Handle;
+#else
+  int m_File;
+#endif
+};
+
+}
+
+Cache::Cache(const std::string& directory, uint64_t maxSize)
+: m_Directory(directory),
+  m_MaxSize(maxSize)
+{
+  if (!m_Directory.empty() && m_Directory.back() != '/' && m_Directory.back() != '\\')
+  {
+    m_Directory += '/';
+  }
+
+#ifdef _WIN32
+  _mkdir(m_Directory.c_str());
+#else
+  mkdir(m_Directory.c_str(), 0777);
+#endif
+
+  m_Entries = LoadIndex();
+  for (auto& e : m_Entries)
+  {
+    m_Statistics.size += e.second.size;
+    m_Clock = std::max(m_Clock, e.second.lastUsed);
+  }
+}
+
+Cache::~Cache()
+{
+  SaveIndex();
+}
+
+bool Cache::Fetch(const std::string& inPath, const std::string& settings, const std::string& outBasePath,
+  ConversionStats& stats)
+{
+  std::string key;
+  bool success = GetKey(inPath, settings, outBasePath, key);
+
+  const std::string entryPath = m_Directory + key;
+  std::ifstream manifest(entryPath + ENTRY_EXTENSION);
+  std::string line;
+  success = success && manifest && std::getline(manifest, line) && line == CACHE_VERSION;
+
+  // Check that the dependencies haven't changed.
+  const std::string inDir = GetDirectory(inPath);
+  std::vector<std::string> animations;
+  while (success && std::getline(manifest, line))
+  {
+    std::istringstream fields(line);
+    std::string type;
+    std::getline(fields, type, '\t');
+    if (type == "dependency")
+    {
+      std::string hash, relative, path;
+      std::getline(fields, hash, '\t');
+      std::getline(fields, relative, '\t');
+      std::getline(fields, path);
+
+      uint64_t currentHash;
+      success = HashFile(relative == "r" ? inDir + path : path, currentHash) && ToHex(currentHash) == hash;
+    }
+    else if (type == "animation")
+    {
+      std::string name;
+      std::getline(fields, name);
+      animations.push_back(name);
+    }
+  }
+
+  // Materialize the outputs.
+  uint64_t size = 0;
+  success = success && CopyFile(entryPath + ".dli", outBasePath + ".dli", stats.dliSize) &&
+    CopyFile(entryPath + ".bin", outBasePath + ".bin", stats.binSize);
+
+  const std::string outDir = GetDirectory(outBasePath);
+  stats.aniSize = 0;
+  for (unsigned int i = 0; success && i < animations.size(); ++i)
+  {
+    success = CopyFile(GetAnimationPath(entryPath, i), outDir + animations[i], size);
+    stats.aniSize += size;
+  }
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (success)
+  {
+    ++m_Statistics.hits;
+    Touch(key, stats.dliSize + stats.binSize + stats.aniSize);
+  }
+  else
+  {
+    ++m_Statistics.misses;
+  }
+  return success;
+}
+
+void Cache::Store(const std::string& inPath, const std::string& settings, const std::vector<std::string>& dependencies,
+  const std::string& outBasePath, const AnimationContents& animations)
+{
+  std::string key;
+  if (!GetKey(inPath, settings, outBasePath, key))
+  {
+    return;
+  }
+
+  std::ostringstream manifest;
+  manifest << CACHE_VERSION << '\n';
+
+  const std::string inDir = GetDirectory(inPath);
+  for (auto& d : dependencies)
+  {
+    uint64_t hash;
+    if (d == inPath || !HashFile(d, hash))
+    {
+      continue;
+    }
+
+    const bool isRelative = inDir.empty() ? !IsAbsolute(d) : d.compare(0, inDir.size(), inDir) == 0;
+    manifest << "dependency\t" << ToHex(hash) << '\t' << (isRelative ? "r\t" + d.substr(inDir.size()) : "a\t" + d) << '\n';
+  }
+
+  for (auto& a : animations)
+  {
+    manifest << "animation\t" << a.first << '\n';
+  }
+
+  // Write everything under a temporary name first, then move it in place; the
+  // manifest last, as that's what makes the entry valid.
+  std::random_device random;
+  const std::string entryPath = m_Directory + key;
+  const std::string tempPath = entryPath + '.' + ToHex((static_cast<uint64_t>(random()) << 32) ^ random());
+  uint64_t size = 0;
+  uint64_t fileSize;
+  bool success = CopyFile(outBasePath + ".dli", tempPath + ".dli", fileSize) && Rename(tempPath + ".dli", entryPath + ".dli");
+  size += fileSize;
+  success = success && CopyFile(outBasePath + ".bin", tempPath + ".bin", fileSize) && Rename(tempPath + ".bin", entryPath + ".bin");
+  size += fileSize;
+
+  unsigned int i = 0;
+  for (auto iAnim = animations.begin(); success && iAnim != animations.end(); ++iAnim, ++i)
+  {
+    success = WriteFile(tempPath, iAnim->second) && Rename(tempPath, GetAnimationPath(entryPath, i));
+    size += iAnim->second.size();
+  }
+
+  success = success && WriteFile(tempPath, manifest.str()) && Rename(tempPath, entryPath + ENTRY_EXTENSION);
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (success)
+  {
+    ++m_Statistics.stores;
+    Touch(key, size);
+    Evict();
+  }
+}
+
+Cache::Statistics Cache::GetStatistics() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Statistics;
+}
+
+bool Cache::GetKey(const std::string& inPath, const std::string& settings, const std::string& outBasePath, std::string& key) const
+{
+  uint64_t hash;
+  if (!HashFile(inPath, hash))
+  {
+    return false;
+  }
+
+  // The .dli refers to the .bin by name, so that's part of the key too.
+  const std::string context = std::string(CACHE_VERSION) + '\n' + settings + '\n' + GetFileName(outBasePath);
+  key = ToHex(Hash64(context.data(), context.size(), hash));
+  return true;
+}
+
+void Cache::Touch(const std::string& key, uint64_t size)
+{
+  auto iFind = m_Entries.find(key);
+  if (iFind != m_Entries.end())
+  {
+    m_Statistics.size -= iFind->second.size;
+  }
+
+  m_Entries[key] = { size, ++m_Clock };
+  m_Statistics.size += size;
+}
+
+void Cache::Evict()
+{
+  // Keep the most recently used entry, regardless of the size.
+  while (m_MaxSize > 0 && m_Statistics.size > m_MaxSize && m_Entries.size() > 1)
+  {
+    auto iOldest = m_Entries.begin();
+    for (auto i = m_Entries.begin(); i != m_Entries.end(); ++i)
+    {
+      if (i->second.lastUsed < iOldest->second.lastUsed)
+      {
+        iOldest = i;
+      }
+    }
+
+    Remove(iOldest->first);
+    m_Statistics.size -= iOldest->second.size;
+    ++m_Statistics.evictions;
+    m_Entries.erase(iOldest);
+  }
+}
+
+void Cache::Remove(const std::string& key)
+{
+  const std::string entryPath = m_Directory + key;
+  unsigned int numAnimations = 0;
+  {
+    std::ifstream manifest(entryPath + ENTRY_EXTENSION);
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+      numAnimations += line.compare(0, 10, "animation\t") == 0 ? 1 : 0;
+    }
+  }
+
+  // The manifest goes first, so that the entry is no longer valid.
+  std::remove((entryPath + ENTRY_EXTENSION).c_str());
+  std::remove((entryPath + ".dli").c_str());
+  std::remove((entryPath + ".bin").c_str());
+  for (unsigned int i = 0; i < numAnimations; ++i)
+  {
+    std::remove(GetAnimationPath(entryPath, i).c_str());
+  }
+}
+
+std::map<std::string, Cache::Entry> Cache::LoadIndex() const
+{
+  std::map<std::string, Entry> entries;
+  std::ifstream index(m_Directory + INDEX_FILE_NAME);
+  std::string key;
+  Entry entry;
+  while (index >> key >> entry.size >> entry.lastUsed)
+  {
+    entries[key] = entry;
+  }
+  return entries;
+}
+
+void Cache::SaveIndex()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  // Other processes may have used the cache since the index was loaded; merge
+  // their changes, and evict from the result, so that the entries that all of
+  // them have stored count towards the size.
+  FileLock fileLock(m_Directory + LOCK_FILE_NAME);
+  auto entries = LoadIndex();
+  for (auto& e : m_Entries)
+  {
+    auto iFind = entries.find(e.first);
+    if (iFind == entries.end() || iFind->second.lastUsed < e.second.lastUsed)
+    {
+      entries[e.first] = e.second;
+    }
+  }
+
+  // Drop the entries that have been evicted since.
+  m_Statistics.size = 0;
+  for (auto i = entries.begin(); i != entries.end();)
+  {
+    if (std::ifstream(m_Directory + i->first + ENTRY_EXTENSION))
+    {
+      m_Statistics.size += i->second.size;
+      ++i;
+    }
+    else
+    {
+      i = entries.erase(i);
+    }
+  }
+  m_Entries.swap(entries);
+  Evict();
+
+  const std::string indexPath = m_Directory + INDEX_FILE_NAME;
+  const std::string tempPath = indexPath + ".tmp";
+  {
+    std::ofstream index(tempPath);
+    for (auto& e : m_Entries)
+    {
+      index << e.first << '\t' << e.second.size << '\t' << e.second.lastUsed << '\n';
+    }
+  }
+  Rename(tempPath, indexPath);
+}
@@ -0,0 +1,104 @@
+#ifndef CACHE_H
+#define CACHE_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ConversionStats;
+
+///@brief Stores the outputs of conversions in a directory, so that converting
+/// inputs that haven't changed since doesn't need to involve assimp.
+///
+/// Entries are keyed by a hash of the contents of the input file, the name of
+/// the .bin (which the .dli refers to), and a string identifying the settings
+/// of the conversion. They also record the other files that assimp has read
+/// while importing the input, and their hashes; an entry is only used if these
+/// haven't changed either. Dependencies within the directory of the input are
+/// recorded relative to it.
+///
+/// When the total size of the entries exceeds the maximum, the least recently
+/// used ones are evicted. Use is tracked in an index in the cache directory,
+/// which is read on construction, and merged with the changes of other
+/// processes using the same directory - under a lock of it - on destruction.
+///@note The methods are thread safe.
+class Cache
+{
+public:
+  using AnimationContents = std::map<std::string, std::string>;
+
+  struct Statistics
+  {
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    unsigned int stores = 0;
+    unsigned int evictions = 0;
+    uint64_t size = 0;  // the total size of the entries, in bytes.
+  };
+
+  ///@param maxSize The size, in bytes, that the entries are allowed to take up;
+  /// 0 means unlimited.
+  Cache(const std::string& directory, uint64_t maxSize);
+  ~Cache();
+
+  Cache(const Cache&) = delete;
+  Cache& operator=(const Cache&) = delete;
+
+  ///@brief Writes the outputs of converting @a inPath with the given @a settings,
+  /// to @a outBasePath.dli, .bin, and the animations next to them, if they're
+  /// in the cache and their dependencies are unchanged.
+  ///@return Whether the outputs were written; if so, their sizes are recorded
+  /// in @a stats.
+  bool Fetch(const std::string& inPath, const std::string& settings, const std::string& outBasePath,
+    ConversionStats& stats);
+
+  ///@brief Stores @a outBasePath.dli and .bin, and the @a animations, which are
+  /// the result of converting @a inPath with the given @a settings, and which
+  /// have required reading the files at @a dependencies.
+  void Store(const std::string& inPath, const std::string& settings, const std::vector<std::string>& dependencies,
+    const std::string& outBasePath, const AnimationContents& animations);
+
+  Statistics GetStatistics() const;
+
+private:
+  struct Entry
+  {
+    uint64_t size;
+    uint64_t lastUsed;
+  };
+
+  bool GetKey(const std::string& inPath, const std::string& settings, const std::string& outBasePath, std::string& key) const;
+  void Touch(const std::string& key, uint64_t size);
+  void Evict();
+  void Remove(const std::string& key);
+  std::map<std::string, Entry> LoadIndex() const;
+  void SaveIndex();
+
+  std::string m_Directory;
+  uint64_t m_MaxSize;
+
+  mutable std::mutex m_Mutex;
+  std::map<std::string, Entry> m_Entries;
+  uint64_t m_Clock = 0;   // incremented on each use of an entry.
+  Statistics m_Statistics;
+};
+
+#endif // CACHE_H
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "Converter.h"
+#include "assimp/scene.h"
+#include "assimp/postprocess.h"
+#include "assimp/DefaultIOSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include "Cache.h"
+#include "Scene3D.h"
+#include "LoadScene.h"
+
+const unsigned int POST_PROCESS_FLAGS = aiProcess_CalcTangentSpace | aiProcess_SortByPType |
+  aiProcess_Triangulate | aiProcess_JoinIdenticalVertices;
+
+namespace
+{
+
+std::string::size_type FindFileName(const std::string& path)
+{
+  auto iSeparator = path.find_last_of("\\/");
+  return iSeparator != std::string::npos ? iSeparator + 1 : 0;
+}
+
+std::string StripExtension(const std::string& path)
+{
+  auto iDot = path.rfind('.');
+  return (iDot != std::string::npos && iDot >= FindFileName(path)) ? path.substr(0, iDot) : path;
+}
+
+}
+
+std::string GetOutputBasePath(const std::string& inPath, const std::string& outPath)
+{
+  return StripExtension(outPath.empty() ? inPath : outPath);
+}
+
+///@brief Keeps track of the files that the importer has opened, i.e. the input
+/// and any other files it refers to.
+class Converter::RecordingIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+  Assimp::IOStream* Open(const char* pFile, const char* pMode) override
+  {
+    Assimp::IOStream* stream = DefaultIOSystem::Open(pFile, pMode);
+    if (stream)
+    {
+      m_OpenedFiles.push_back(pFile);
+    }
+    return stream;
+  }
+
+  std::vector<std::string> m_OpenedFiles;
+};
+
+Converter::Converter(WorkerPool* workers, Cache* cache, const SaveOptions& options)
+: m_IOSystem(new RecordingIOSystem()),
+  m_Workers(workers),
+  m_Cache(cache),
+  m_Options(options)
+{
+  m_Importer.SetIOHandler(m_IOSystem);
+}
+
+std::string Converter::GetSettings() const
+{
+  // The memory budget is left out, as it doesn't affect the output.
+  char buffer[512];
+  snprintf(buffer, sizeof(buffer), "postprocess=%x materials=0 binaryAnimations=1 compact=%d binary=%d "
+    "deduplicateMeshes=%d shortIndices=%d optimizeVertexCache=%d optimizeOverdraw=%d overdrawThreshold=%g "
+    "optimizeVertexFetch=%d positionEncoding=%s normalEncoding=%s textureEncoding=%s interleaved=%d "
+    "separatePositions=%d numLods=%u lodRatio=%g constantAttributes=%d shareBuffers=%d "
+    "bufferAlignment=%u",
+    POST_PROCESS_FLAGS,
+    m_Options.compact, m_Options.binary, m_Options.deduplicateMeshes, m_Options.shortIndices,
+    m_Options.optimizeVertexCache, m_Options.optimizeOverdraw, m_Options.overdrawThreshold,
+    m_Options.optimizeVertexFetch, VertexEncoding::GetName(m_Options.positionEncoding),
+    VertexEncoding::GetName(m_Options.normalEncoding), VertexEncoding::GetName(m_Options.textureEncoding),
+    m_Options.interleaved, m_Options.separatePositions, m_Options.numLods, m_Options.lodRatio,
+    m_Options.constantAttributes, m_Options.shareBuffers, m_Options.bufferAlignment);
+  return buffer;
+}
+
+bool Converter::Convert(const std::string& inPath, const std::string& binName, std::ostream& outDli,
+  std::ostream& outBin, AnimationContents& animations, std::string& error)
+{
+  m_IOSystem->m_OpenedFiles.clear();
+  const aiScene* scene = m_Importer.ReadFile(inPath, 0u);
+  if (!scene)
+  {
+    error = "Failed to process scene file '" + inPath + "':" + m_Importer.GetErrorString();
+    return false;
+  }
+
+  scene = m_Importer.ApplyPostProcessing(POST_PROCESS_FLAGS);
+  if (!scene)
+  {
+    error = "Failed to post-process scene file '" + inPath + "':" + m_Importer.GetErrorString();
+    return false;
+  }
+
+  Scene3D scene_data;
+  MeshIds meshIds;
+  SceneNodeIndex nodeIndex(scene);
+  GetSceneNodes(scene_data, meshIds, nullptr, scene, scene->mRootNode, nodeIndex);
+  PackSceneNodeMeshIds(scene_data, meshIds);
+  GetSceneMeshes(scene_data, meshIds, scene, m_Workers, m_Options.memoryBudget > 0);
+  GetSceneCameras(scene_data, scene, nodeIndex);
+  GetSceneLights(scene_data, scene, nodeIndex);
+  GetAnimations(scene_data, scene);
+
+  bool result = ConvertScene(&scene_data, binName, outDli, outBin, false, true, &animations, m_Workers, m_Options);
+  m_Importer.FreeScene();
+  if (!result)
+  {
+    error = "Failed to convert scene file '" + inPath + "'.";
+  }
+  return result;
+}
+
+bool Converter::ConvertFile(const std::string& inPath, const std::string& outBasePath, ConversionStats& stats)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  if (m_Cache && m_Cache->Fetch(inPath, GetSettings(), outBasePath, stats))
+  {
+    stats.success = true;
+    stats.cached = true;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+  }
+
+  const std::string binPath = outBasePath + ".bin";
+  std::ofstream ofsBin(binPath, std::ios::binary);
+  std::ofstream ofsDli(outBasePath + ".dli");
+
+  AnimationContents animations;
+  stats.success = ofsBin && ofsDli;
+  if (!stats.success)
+  {
+    stats.error = "Failed to open '" + outBasePath + "' for writing.";
+  }
+  else
+  {
+    stats.success = Convert(inPath, binPath, ofsDli, ofsBin, animations, stats.error);
+  }
+
+  if (!stats.success)
+  {
+    // Don't leave partial outputs behind.
+    ofsBin.close();
+    ofsDli.close();
+    std::remove(binPath.c_str());
+    std::remove((outBasePath + ".dli").c_str());
+  }
+  else
+  {
+    stats.dliSize = ofsDli.tellp();
+    stats.binSize = ofsBin.tellp();
+
+    // The animation files go next to the .bin.
+    const std::string outDir = outBasePath.substr(0, FindFileName(outBasePath));
+    for (auto& a : animations)
+    {
+      std::ofstream ofsAni(outDir + a.first, std::ios::binary);
+      ofsAni.write(a.second.data(), a.second.size());
+      stats.aniSize += a.second.size();
+    }
+
+    if (m_Cache)
+    {
+      ofsBin.close();
+      ofsDli.close();
+      m_Cache->Store(inPath, GetSettings(), m_IOSystem->m_OpenedFiles, outBasePath, animations);
+    }
+  }
+
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return stats.success;
+}
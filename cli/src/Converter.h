@@ -0,0 +1,93 @@
+#ifndef CONVERTER_H
+#define CONVERTER_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "assimp/Importer.hpp"
+#include "SaveScene.h"
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Cache;
+class WorkerPool;
+
+///@brief The post-processing steps that scenes are imported with.
+extern const unsigned int POST_PROCESS_FLAGS;
+
+///@return The path, without extension, that the .dli and .bin converted from
+/// @a inPath are written to. If @a outPath is empty, this is based on @a inPath.
+std::string GetOutputBasePath(const std::string& inPath, const std::string& outPath);
+
+///@brief Outcome of converting a single file.
+struct ConversionStats
+{
+  bool success = false;
+  std::string error;
+  double seconds = 0.0;
+  uint64_t dliSize = 0;
+  uint64_t binSize = 0;
+  uint64_t aniSize = 0;   // the total of all animation files.
+  bool cached = false;    // whether the outputs were fetched from the cache.
+};
+
+///@brief Imports scenes and converts them to .dli. Keeps hold of its importer,
+/// which registers all importers and post-processing steps when created, so
+/// that this cost is only paid once per Converter.
+///@note Not thread safe; use a Converter per thread.
+class Converter
+{
+public:
+  using AnimationContents = std::map<std::string, std::string>;
+
+  ///@param workers Optional; used to convert the meshes of each scene.
+  ///@param cache Optional; ConvertFile() fetches its outputs from here, if they
+  /// are present, and stores them otherwise.
+  ///@param options The options that scenes are saved with.
+  explicit Converter(WorkerPool* workers = nullptr, Cache* cache = nullptr,
+    const SaveOptions& options = SaveOptions());
+
+  ///@brief Converts the scene at @a inPath, writing the .dli and .bin data to the
+  /// given streams, and the binary animations into @a animations.
+  ///@param binName The file name that the .dli refers to the .bin by.
+  ///@note Doesn't use the cache.
+  ///@return The success of the operation; if it failed, @a error is set.
+  bool Convert(const std::string& inPath, const std::string& binName, std::ostream& outDli,
+    std::ostream& outBin, AnimationContents& animations, std::string& error);
+
+  ///@brief Converts the scene at @a inPath, writing @a outBasePath.dli, .bin,
+  /// and the animation files next to them.
+  ///@return The success of the operation, also recorded in @a stats.
+  bool ConvertFile(const std::string& inPath, const std::string& outBasePath, ConversionStats& stats);
+
+  ///@return A string identifying the settings that conversions are performed
+  /// with, i.e. what, besides the input, affects the output.
+  std::string GetSettings() const;
+
+private:
+  class RecordingIOSystem;
+
+  Assimp::Importer m_Importer;
+  RecordingIOSystem* m_IOSystem;  // owned by m_Importer.
+  WorkerPool* m_Workers;
+  Cache* m_Cache;
+  SaveOptions m_Options;
+};
+
+#endif // CONVERTER_H
@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "Server.h"
+#include "Converter.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <streambuf>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+///@brief A stream buffer that holds on to its storage when it's Reset(), so that
+/// consecutive conversions don't need to reallocate it.
+class ScratchBuffer : public std::streambuf
+{
+public:
+  void Reset()
+  {
+    setp(m_Data.data(), m_Data.data() + m_Data.size());
+  }
+
+  const char* GetData() const
+  {
+    return pbase();
+  }
+
+  size_t GetSize() const
+  {
+    return pptr() - pbase();
+  }
+
+protected:
+  int_type overflow(int_type c) override
+  {
+    const size_t size = GetSize();
+    m_Data.resize(std::max<size_t>(m_Data.size() * 2, 1 << 16));
+    setp(m_Data.data(), m_Data.data() + m_Data.size());
+    Advance(size);
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+private:
+  void Advance(size_t n)
+  {
+    // pbump() takes an int.
+    while (n > 0)
+    {
+      const int step = static_cast<int>(std::min<size_t>(n, INT_MAX));
+      pbump(step);
+      n -= step;
+    }
+  }
+
+  std::vector<char> m_Data;
+};
+
+struct Blob
+{
+  std::string name;
+  const char* data;
+  size_t size;
+};
+
+std::vector<std::string> Split(const std::string& line, char separator)
+{
+  std::vector<std::string> fields;
+  std::string::size_type i0 = 0;
+  while (true)
+  {
+    auto i1 = line.find(separator, i0);
+    fields.push_back(line.substr(i0, i1 - i0));
+    if (i1 == std::string::npos)
+    {
+      break;
+    }
+    i0 = i1 + 1;
+  }
+  return fields;
+}
+
+///@brief Makes @a message safe to send as the last field of a response line.
+std::string Sanitize(std::string message)
+{
+  for (auto& c : message)
+  {
+    if (c == '\t' || c == '\n' || c == '\r')
+    {
+      c = ' ';
+    }
+  }
+  return message;
+}
+
+}
+
+///@brief A source of requests, and a destination for their responses. Responses
+/// may be sent from multiple threads; each is sent as a whole.
+class Connection
+{
+public:
+  virtual ~Connection()
+  {}
+
+  ///@brief Reads the next request line into @a line.
+  ///@return false if the connection was closed.
+  virtual bool ReadLine(std::string& line) = 0;
+
+  ///@brief Stops reading further requests.
+  virtual void Close()
+  {}
+
+  void Send(const std::string& header, const std::vector<Blob>& blobs)
+  {
+    std::lock_guard<std::mutex> lock(m_WriteMutex);
+    bool success = Write(header.data(), header.size());
+    for (auto i = blobs.begin(); success && i != blobs.end(); ++i)
+    {
+      const std::string blobHeader = i->name + '\t' + std::to_string(i->size) + '\n';
+      success = Write(blobHeader.data(), blobHeader.size()) && Write(i->data, i->size);
+    }
+    Flush();
+  }
+
+protected:
+  virtual bool Write(const char* data, size_t size) = 0;
+
+  virtual void Flush()
+  {}
+
+private:
+  std::mutex m_WriteMutex;
+};
+
+namespace
+{
+
+class StdioConnection : public Connection
+{
+public:
+  StdioConnection(std::streambuf* output)
+  : m_Output(output)
+  {}
+
+  bool ReadLine(std::string& line) override
+  {
+    return static_cast<bool>(std::getline(std::cin, line));
+  }
+
+protected:
+  bool Write(const char* data, size_t size) override
+  {
+    return static_cast<bool>(m_Output.write(data, size));
+  }
+
+  void Flush() override
+  {
+    m_Output.flush();
+  }
+
+private:
+  std::ostream m_Output;
+};
+
+#ifndef _WIN32
+class SocketConnection : public Connection
+{
+public:
+  SocketConnection(int socket)
+  : m_Socket(socket)
+  {}
+
+  ~SocketConnection()
+  {
+    close(m_Socket);
+  }
+
+  bool ReadLine(std::string& line) override
+  {
+    while (true)
+    {
+      auto iNewLine = m_ReadBuffer.find('\n');
+      if (iNewLine != std::string::npos)
+      {
+        line = m_ReadBuffer.substr(0, iNewLine);
+        m_ReadBuffer.erase(0, iNewLine + 1);
+        return true;
+      }
+
+      char buffer[4096];
+      const ssize_t numRead = recv(m_Socket, buffer, sizeof(buffer), 0);
+      if (numRead < 0 && errno == EINTR)
+      {
+        continue;
+      }
+
+      if (numRead <= 0)
+      {
+        return false;
+      }
+      m_ReadBuffer.append(buffer, numRead);
+    }
+  }
+
+  void Close() override
+  {
+    shutdown(m_Socket, SHUT_RD);
+  }
+
+protected:
+  bool Write(const char* data, size_t size) override
+  {
+    while (size > 0)
+    {
+      const ssize_t numWritten = send(m_Socket, data, size, MSG_NOSIGNAL);
+      if (numWritten < 0 && errno == EINTR)
+      {
+        continue;
+      }
+
+      if (numWritten <= 0)
+      {
+        return false;
+      }
+      data += numWritten;
+      size -= numWritten;
+    }
+    return true;
+  }
+
+private:
+  int m_Socket;
+  std::string m_ReadBuffer;
+};
+#endif
+
+}
+
+struct Server::Request
+{
+  std::shared_ptr<Connection> connection;
+  std::string id;
+  bool isInline;
+  std::string inPath;
+  std::string outPath;
+};
+
+struct Server::Worker
+{
+  Worker(Cache* cache, const SaveOptions& options)
+  : converter(nullptr, cache, options)
+  {}
+
+  Converter converter;
+  ScratchBuffer dli;
+  ScratchBuffer bin;
+  Converter::AnimationContents animations;
+};
+
+Server::Server(unsigned int numWorkers, Cache* cache, const SaveOptions& options)
+{
+  if (numWorkers == 0)
+  {
+    numWorkers = WorkerPool::GetDefaultNumThreads();
+  }
+
+  for (unsigned int i = 0; i < numWorkers; ++i)
+  {
+    m_Workers.emplace_back(new Worker(cache, options));
+  }
+
+  for (auto& w : m_Workers)
+  {
+    m_Threads.emplace_back(&Server::WorkerMain, this, std::ref(*w));
+  }
+}
+
+Server::~Server()
+{
+  Stop();
+}
+
+int Server::ServeStdio()
+{
+#ifdef _WIN32
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+  // Keep the standard output for the responses.
+  std::streambuf* stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+  Serve(std::make_shared<StdioConnection>(stdoutBuffer));
+  Stop();
+
+  std::cout.rdbuf(stdoutBuffer);
+  return 0;
+}
+
+int Server::ServeSocket(const std::string& path)
+{
+#ifdef _WIN32
+  std::cerr << "Serving from a socket is not supported on this platform." << std::endl;
+  return 1;
+#else
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    std::cerr << "Socket path '" << path << "' is too long." << std::endl;
+    return 1;
+  }
+  strcpy(address.sun_path, path.c_str());
+
+  const int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path.c_str());
+  if (listenSocket < 0 ||
+    bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+    listen(listenSocket, SOMAXCONN) != 0)
+  {
+    std::cerr << "Failed to listen on '" << path << "': " << strerror(errno) << std::endl;
+    if (listenSocket >= 0)
+    {
+      close(listenSocket);
+    }
+    return 1;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_ListenSocket = listenSocket;
+  }
+
+  struct Reader
+  {
+    std::shared_ptr<Connection> connection;
+    std::shared_ptr<std::atomic<bool>> done;
+    std::thread thread;
+  };
+  std::vector<Reader> readers;
+
+  while (true)
+  {
+    const int socket = accept(listenSocket, nullptr, nullptr);
+    if (socket < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      break;  // including when a shutdown request has shut the listening socket down.
+    }
+
+    // Clean up after the connections which have been closed.
+    for (auto i = readers.begin(); i != readers.end();)
+    {
+      if (*i->done)
+      {
+        i->thread.join();
+        i = readers.erase(i);
+      }
+      else
+      {
+        ++i;
+      }
+    }
+
+    Reader reader;
+    reader.connection = std::make_shared<SocketConnection>(socket);
+    reader.done = std::make_shared<std::atomic<bool>>(false);
+    reader.thread = std::thread([this](std::shared_ptr<Connection> connection, std::shared_ptr<std::atomic<bool>> done) {
+      Serve(connection);
+      *done = true;
+    }, reader.connection, reader.done);
+    readers.push_back(std::move(reader));
+  }
+
+  for (auto& r : readers)
+  {
+    r.connection->Close();
+  }
+
+  for (auto& r : readers)
+  {
+    r.thread.join();
+  }
+
+  Stop();
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_ListenSocket = -1;
+  }
+  close(listenSocket);
+  unlink(path.c_str());
+  return 0;
+#endif
+}
+
+void Server::Serve(const std::shared_ptr<Connection>& connection)
+{
+  std::string line;
+  while (connection->ReadLine(line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+
+    if (line.empty())
+    {
+      continue;
+    }
+
+    auto fields = Split(line, '\t');
+    if (fields[0] == "shutdown")
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+#ifndef _WIN32
+      if (m_ListenSocket >= 0)
+      {
+        shutdown(m_ListenSocket, SHUT_RDWR);
+      }
+#endif
+      break;
+    }
+
+    if (fields[0] != "convert" || fields.size() < 4 || (fields[2] != "files" && fields[2] != "inline"))
+    {
+      const std::string id = fields.size() > 1 ? fields[1] : "";
+      connection->Send(id + "\tFAILED\t0\tInvalid request '" + Sanitize(line) + "'.\n", {});
+      continue;
+    }
+
+    std::unique_ptr<Request> request(new Request());
+    request->connection = connection;
+    request->id = fields[1];
+    request->isInline = fields[2] == "inline";
+    request->inPath = fields[3];
+    if (fields.size() > 4)
+    {
+      request->outPath = fields[4];
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_Requests.push_back(std::move(request));
+    }
+    m_Condition.notify_one();
+  }
+}
+
+void Server::WorkerMain(Worker& worker)
+{
+  while (true)
+  {
+    std::unique_ptr<Request> request;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_Condition.wait(lock, [this]() {
+        return m_Stopping || !m_Requests.empty();
+      });
+
+      if (m_Requests.empty())
+      {
+        break;
+      }
+
+      request = std::move(m_Requests.front());
+      m_Requests.pop_front();
+    }
+
+    Process(worker, *request);
+  }
+}
+
+void Server::Process(Worker& worker, const Request& request)
+{
+  auto start = std::chrono::steady_clock::now();
+  const std::string outBasePath = GetOutputBasePath(request.inPath, request.outPath);
+
+  ConversionStats stats;
+  std::vector<Blob> blobs;
+
+  // A failure to convert one request mustn't take the rest down with it.
+  try
+  {
+    if (request.isInline)
+    {
+      worker.dli.Reset();
+      worker.bin.Reset();
+      worker.animations.clear();
+
+      std::ostream dli(&worker.dli);
+      std::ostream bin(&worker.bin);
+      const std::string name = outBasePath.substr(outBasePath.find_last_of("\\/") + 1);
+      stats.success = worker.converter.Convert(request.inPath, name + ".bin", dli, bin, worker.animations, stats.error);
+      if (stats.success)
+      {
+        blobs.push_back({ name + ".dli", worker.dli.GetData(), worker.dli.GetSize() });
+        blobs.push_back({ name + ".bin", worker.bin.GetData(), worker.bin.GetSize() });
+        stats.dliSize = worker.dli.GetSize();
+        stats.binSize = worker.bin.GetSize();
+        for (auto& a : worker.animations)
+        {
+          blobs.push_back({ a.first, a.second.data(), a.second.size() });
+          stats.aniSize += a.second.size();
+        }
+      }
+    }
+    else
+    {
+      worker.converter.ConvertFile(request.inPath, outBasePath, stats);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    stats.success = false;
+    stats.error = "Failed to convert scene file '" + request.inPath + "': " + e.what();
+    blobs.clear();
+  }
+  catch (...)
+  {
+    stats.success = false;
+    stats.error = "Failed to convert scene file '" + request.inPath + "'.";
+    blobs.clear();
+  }
+
+  const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::string header = request.id + '\t';
+  if (stats.success)
+  {
+    header += "OK\t" + std::to_string(milliseconds) + '\t' + std::to_string(stats.dliSize) + '\t' +
+      std::to_string(stats.binSize) + '\t' + std::to_string(stats.aniSize) + '\t' +
+      std::to_string(blobs.size()) + '\n';
+  }
+  else
+  {
+    header += "FAILED\t" + std::to_string(milliseconds) + '\t' + Sanitize(stats.error) + '\n';
+  }
+  request.connection->Send(header, blobs);
+}
+
+void Server::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stopping = true;
+  }
+  m_Condition.notify_all();
+
+  for (auto& t : m_Threads)
+  {
+    t.join();
+  }
+  m_Threads.clear();
+}
@@ -0,0 +1,95 @@
+#ifndef SERVER_H
+#define SERVER_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "SaveScene.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Cache;
+class Connection;
+
+///@brief Keeps a number of Converters warm, and serves conversion requests from
+/// the standard input, or connections to a unix domain socket.
+///
+/// Requests are single lines, with tab separated fields:
+/// convert <id> <files|inline> <input path> [<output path>]
+/// shutdown
+///
+/// The response to each convert request starts with a line, whose fields are:
+/// <id> OK <milliseconds> <.dli bytes> <.bin bytes> <.ani bytes> <number of blobs>
+/// <id> FAILED <milliseconds> <error message>
+/// In files mode, the outputs are written to the filesystem, as for a single
+/// conversion, and there are no blobs. In inline mode, nothing is written; the
+/// .dli, the .bin and the animations follow the response line as blobs, each
+/// made up of a line with its name and size in bytes (tab separated), and then
+/// the bytes themselves.
+///
+/// Requests are processed concurrently, so responses may arrive in a different
+/// order than the requests; use the id to match them up. A shutdown request
+/// stops the server once all pending requests have been responded to.
+class Server
+{
+public:
+  ///@param numWorkers The number of conversions to perform concurrently; 0 means
+  /// one per hardware thread.
+  ///@param cache Optional; used by requests in files mode. Refer to Converter.
+  ///@param options The options that scenes are saved with.
+  explicit Server(unsigned int numWorkers, Cache* cache = nullptr, const SaveOptions& options = SaveOptions());
+  ~Server();
+
+  ///@brief Serves requests from the standard input, until it's closed or a
+  /// shutdown request. Responses are written to the standard output; anything
+  /// else that would've been is redirected to the standard error.
+  ///@return An exit code for the process.
+  int ServeStdio();
+
+  ///@brief Serves requests from connections to a unix domain socket created at
+  /// @a path, until a shutdown request.
+  ///@return An exit code for the process.
+  int ServeSocket(const std::string& path);
+
+private:
+  struct Request;
+  struct Worker;
+
+  ///@brief Reads requests from @a connection and queues them, until it's closed
+  /// or a shutdown request.
+  void Serve(const std::shared_ptr<Connection>& connection);
+  void WorkerMain(Worker& worker);
+  void Process(Worker& worker, const Request& request);
+
+  ///@brief Lets the workers finish the requests that are already queued, then stops them.
+  void Stop();
+
+  std::vector<std::unique_ptr<Worker>> m_Workers;
+  std::vector<std::thread> m_Threads;
+
+  std::mutex m_Mutex;
+  std::condition_variable m_Condition;
+  std::deque<std::unique_ptr<Request>> m_Requests;
+  bool m_Stopping = false;
+  int m_ListenSocket = -1;
+};
+
+#endif // SERVER_H
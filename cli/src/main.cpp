@@ -14,65 +14,351 @@
  * limitations under the License.
  *
  */
-#include "assimp/Importer.hpp"
-#include "assimp/scene.h"
-#include "assimp/postprocess.h"
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <cstdlib>
+#include <memory>
+#include <iterator>
 
-#include "Scene3D.h"
-#include "LoadScene.h"
-#include "SaveScene.h"
+#include "Batch.h"
+#include "Cache.h"
+#include "CborReader.h"
+#include "Converter.h"
+#include "JsonWriter.h"
+#include "Server.h"
+#include "WorkerPool.h"
 
-int main(int argc, char **argv)
+namespace
+{
+
+const unsigned long PAGE_ALIGNMENT = 4096;
+const unsigned long MAX_ALIGNMENT = 65536;
+
+///@brief Converts the binary .dli at @a inPath to JSON text, written to @a outPath,
+/// or the standard output if that's empty.
+///@return An exit code for the process.
+int Decode(const std::string& inPath, const std::string& outPath)
 {
-  if (argc < 2)
+  std::ifstream ifs(inPath, std::ios::binary);
+  const std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  if (!ifs)
   {
-    std::cerr << "Missing input parameter." << std::endl;
+    std::cerr << "Failed to read '" << inPath << "'." << std::endl;
     return 1;
   }
 
-  std::string inPath = argv[1];
-  Assimp::Importer importer;
+  std::ofstream ofs;
+  if (!outPath.empty())
+  {
+    ofs.open(outPath);
+    if (!ofs)
+    {
+      std::cerr << "Failed to open '" << outPath << "' for writing." << std::endl;
+      return 1;
+    }
+  }
 
-  const aiScene* scene = importer.ReadFile(inPath, 0u);
-  if (!scene)
+  std::ostream& os = outPath.empty() ? std::cout : ofs;
+  bool success;
   {
-    std::cerr << "Failed to process scene file '" << inPath << "':" << importer.GetErrorString() << std::endl;
+    JsonWriter writer(os, "  ");
+    success = CborReader(data.data(), data.size()).Read(writer);
+  }
+  os << std::endl;
+
+  if (!success)
+  {
+    std::cerr << "'" << inPath << "' is not a valid binary .dli." << std::endl;
     return 1;
   }
+  return 0;
+}
 
-  scene = importer.ApplyPostProcessing(aiProcess_CalcTangentSpace | aiProcess_SortByPType | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+///@brief Parses the encoding given for the attribute(s) that @a option is for,
+/// i.e. --position-encoding, from @a name, into @a encoding.
+///@return Whether it was an encoding that the attribute(s) may be written in.
+bool ParseEncoding(const std::string& option, const std::string& name, VertexEncoding::Type& encoding)
+{
+  VertexEncoding::Type type;
+  if (!VertexEncoding::FromName(name, type))
+  {
+    return false;
+  }
 
-  std::string outPath;
-  if (argc > 2)
+  bool valid = type == VertexEncoding::FLOAT32;
+  if (option == "--position-encoding")
+  {
+    valid = valid || type == VertexEncoding::UNORM16;
+  }
+  else if (option == "--normal-encoding")
   {
-    outPath = argv[2];
+    valid = valid || type == VertexEncoding::OCT16 || type == VertexEncoding::OCT8;
   }
   else
   {
-    outPath = inPath;
+    valid = valid || type == VertexEncoding::UNORM16 || type == VertexEncoding::HALF;
   }
 
-  outPath = outPath.substr(0, inPath.rfind('.'));
+  if (valid)
+  {
+    encoding = type;
+  }
+  return valid;
+}
+
+///@brief Parses the alignment of buffers from @a value: a number of bytes, or
+/// "page", for 4096.
+///@return Whether it was a power of two.
+bool ParseAlignment(const std::string& value, unsigned int& alignment)
+{
+  const unsigned long parsed = value == "page" ? PAGE_ALIGNMENT : std::strtoul(value.c_str(), nullptr, 10);
+  const bool valid = parsed > 0 && parsed <= MAX_ALIGNMENT && (parsed & (parsed - 1)) == 0;
+  if (valid)
+  {
+    alignment = static_cast<unsigned int>(parsed);
+  }
+  return valid;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  // Separate options from the positional arguments.
+  std::vector<std::string> args;
+  unsigned int numThreads = 1;
+  bool batch = false;
+  std::vector<BatchJob> jobs;
+  std::string summaryPath;
+  bool serve = false;
+  std::string socketPath;
+  std::string cachePath;
+  uint64_t cacheSize = 4096;  // MB
+  SaveOptions options;
+  bool decode = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    const bool hasValue = arg == "-j" || arg == "--threads" || arg == "--manifest" || arg == "--summary" ||
+      arg == "--socket" || arg == "--cache" || arg == "--cache-size" || arg == "--overdraw-threshold" ||
+      arg == "--position-encoding" || arg == "--normal-encoding" || arg == "--texture-encoding" ||
+      arg == "--lods" || arg == "--lod-ratio" || arg == "--buffer-alignment" || arg == "--memory-budget";
+    if (hasValue && ++i == argc)
+    {
+      std::cerr << "Missing value for " << arg << "." << std::endl;
+      return 1;
+    }
+
+    if (arg == "-j" || arg == "--threads")
+    {
+      numThreads = std::strtoul(argv[i], nullptr, 10);  // 0 means one per hardware thread.
+    }
+    else if (arg == "--batch")
+    {
+      batch = true;
+    }
+    else if (arg == "--manifest")
+    {
+      batch = true;
+      if (!ReadManifest(argv[i], jobs))
+      {
+        std::cerr << "Failed to read manifest '" << argv[i] << "'." << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "--summary")
+    {
+      summaryPath = argv[i];
+    }
+    else if (arg == "--server")
+    {
+      serve = true;
+    }
+    else if (arg == "--socket")
+    {
+      serve = true;
+      socketPath = argv[i];
+    }
+    else if (arg == "--compact")
+    {
+      options.compact = true;
+    }
+    else if (arg == "--binary")
+    {
+      options.binary = true;
+    }
+    else if (arg == "--deduplicate-meshes")
+    {
+      options.deduplicateMeshes = true;
+    }
+    else if (arg == "--short-indices")
+    {
+      options.shortIndices = true;
+    }
+    else if (arg == "--optimize-vertex-cache")
+    {
+      options.optimizeVertexCache = true;
+    }
+    else if (arg == "--optimize-overdraw")
+    {
+      options.optimizeOverdraw = true;
+    }
+    else if (arg == "--overdraw-threshold")
+    {
+      options.overdrawThreshold = std::strtof(argv[i], nullptr);
+    }
+    else if (arg == "--optimize-vertex-fetch")
+    {
+      options.optimizeVertexFetch = true;
+    }
+    else if (arg == "--lods")
+    {
+      options.numLods = std::strtoul(argv[i], nullptr, 10);
+    }
+    else if (arg == "--lod-ratio")
+    {
+      options.lodRatio = std::strtof(argv[i], nullptr);
+    }
+    else if (arg == "--interleave")
+    {
+      options.interleaved = true;
+    }
+    else if (arg == "--separate-positions")
+    {
+      options.separatePositions = true;
+    }
+    else if (arg == "--constant-attributes")
+    {
+      options.constantAttributes = true;
+    }
+    else if (arg == "--share-buffers")
+    {
+      options.shareBuffers = true;
+    }
+    else if (arg == "--buffer-alignment")
+    {
+      if (!ParseAlignment(argv[i], options.bufferAlignment))
+      {
+        std::cerr << "Invalid value for " << arg << ": '" << argv[i] << "'." << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "--memory-budget")
+    {
+      options.memoryBudget = std::strtoull(argv[i], nullptr, 10) << 20;  // in MiB; 0 means unlimited.
+    }
+    else if (arg == "--position-encoding" || arg == "--normal-encoding" || arg == "--texture-encoding")
+    {
+      auto& encoding = arg == "--position-encoding" ? options.positionEncoding :
+        arg == "--normal-encoding" ? options.normalEncoding : options.textureEncoding;
+      if (!ParseEncoding(arg, argv[i], encoding))
+      {
+        std::cerr << "Invalid value for " << arg << ": '" << argv[i] << "'." << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "--decode")
+    {
+      decode = true;
+    }
+    else if (arg == "--cache")
+    {
+      cachePath = argv[i];
+    }
+    else if (arg == "--cache-size")
+    {
+      cacheSize = std::strtoull(argv[i], nullptr, 10);  // 0 means unlimited.
+    }
+    else
+    {
+      args.push_back(arg);
+    }
+  }
+
+  if (decode)
+  {
+    if (args.empty())
+    {
+      std::cerr << "Missing input parameter." << std::endl;
+      return 1;
+    }
+    return Decode(args[0], args.size() > 1 ? args[1] : "");
+  }
+
+  std::unique_ptr<Cache> cache;
+  if (!cachePath.empty())
+  {
+    cache.reset(new Cache(cachePath, cacheSize * 1024 * 1024));
+  }
+
+  auto run = [&]() -> int {
+    if (serve)
+    {
+      Server server(numThreads, cache.get(), options);
+      return socketPath.empty() ? server.ServeStdio() : server.ServeSocket(socketPath);
+    }
+
+    if (batch)
+    {
+      // Each positional argument is an input; the outputs go next to them.
+      for (auto& a : args)
+      {
+        jobs.push_back({ a, "" });
+      }
+
+      std::ofstream ofsSummary;
+      if (!summaryPath.empty())
+      {
+        ofsSummary.open(summaryPath);
+        if (!ofsSummary)
+        {
+          std::cerr << "Failed to open '" << summaryPath << "' for writing." << std::endl;
+          return 1;
+        }
+      }
+
+      // Keep the standard output for the summary; the logs of the jobs, which
+      // are interleaved, go to the standard error.
+      std::streambuf* stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+      std::ostream stdoutSummary(stdoutBuffer);
+      const unsigned int numFailed = RunBatch(jobs, numThreads, summaryPath.empty() ? stdoutSummary : ofsSummary,
+        cache.get(), options);
+      std::cout.rdbuf(stdoutBuffer);
+      return numFailed > 0 ? 1 : 0;
+    }
+
+    if (args.empty())
+    {
+      std::cerr << "Missing input parameter." << std::endl;
+      return 1;
+    }
+
+    std::unique_ptr<WorkerPool> workers;
+    if (numThreads != 1)
+    {
+      workers.reset(new WorkerPool(numThreads));
+    }
 
-  Scene3D scene_data;
-  MeshIds meshIds;
-  GetSceneNodes(scene_data, meshIds, nullptr, scene, scene->mRootNode);
-  PackSceneNodeMeshIds(scene_data, meshIds);
-  GetSceneMeshes(scene_data, meshIds, scene);
-  GetSceneCameras(scene_data, scene);
-  GetSceneLights(scene_data, scene);
-  GetAnimations(scene_data, scene);
+    std::string inPath = args[0];
+    std::string outPath = GetOutputBasePath(inPath, args.size() > 1 ? args[1] : "");
 
-  std::string outBin = outPath + ".bin";
-  std::ofstream ofsBin(outBin, ios::binary);
-  std::ofstream ofsDli(outPath + ".dli");
+    Converter converter(workers.get(), cache.get(), options);
+    ConversionStats stats;
+    if (!converter.ConvertFile(inPath, outPath, stats))
+    {
+      std::cerr << stats.error << std::endl;
+      return 1;
+    }
+    return 0;
+  };
+  const int result = run();
 
-  int result = 0;
-  if (!ConvertScene(&scene_data, outBin, ofsDli, ofsBin, false))
+  if (cache)
   {
-    result = 1;
+    auto stats = cache->GetStatistics();
+    std::cerr << "Cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.stores <<
+      " stored, " << stats.evictions << " evicted, " << stats.size << " bytes." << std::endl;
   }
   return result;
 }
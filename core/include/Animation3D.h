@@ -60,6 +60,7 @@ class NodeAnimation3D
         virtual ~NodeAnimation3D();
 
         std::string NodeName;
+        unsigned int NodeNameId = -1;   // into the names of the Scene3D that the animation is added to.
         std::vector<NodeKey> Rotations;
         std::vector<NodeKey> Positions;
         std::vector<NodeKey> Scales;
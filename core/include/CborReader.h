@@ -0,0 +1,194 @@
+#ifndef CBORREADER_H
+#define CBORREADER_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+///@brief Reference decoder for documents written by JsonWriter in its BINARY
+/// format. Replays the document into a Handler, which has the same interface
+/// as JsonWriter, i.e.:
+/// WriteObject(const char* name, bool oneLiner);
+/// WriteArray(const char* name, bool oneLiner);
+/// WriteValue(const char* name, T value); for const char* (nullptr for null),
+///   int, unsigned int, float, double and bool;
+/// CloseScope();
+/// where name is nullptr for the elements of arrays. A JsonWriter may therefore
+/// be used to convert the document back to JSON text.
+///
+/// Beyond what JsonWriter writes, definite length arrays and maps are supported;
+/// other CBOR features (byte strings, tags other than the leading self-describe
+/// one, non-string keys, 64 bit integers) are rejected.
+class CborReader
+{
+public:
+  CborReader(const char* data, size_t size);
+
+  ///@brief Reads the document, calling @a handler for each element of it.
+  ///@return Whether the whole of the data was a well formed document; if not,
+  /// @a handler may have received a part of it.
+  template <class Handler>
+  bool Read(Handler& handler);
+
+private:
+  enum { MAX_DEPTH = 256 };
+
+  struct Head
+  {
+    unsigned int majorType;
+    unsigned int additionalInfo;
+    uint64_t argument;
+
+    bool IsIndefinite() const
+    {
+      return additionalInfo == 31;
+    }
+  };
+
+  bool ReadHead(Head& head);
+  bool ReadString(const Head& head, std::string& str);
+  bool IsBreak();
+
+  static float HalfToFloat(uint16_t half);
+
+  template <class Handler>
+  bool ReadItem(Handler& handler, const char* name, unsigned int depth);
+
+  const char* m_Data;
+  const char* m_End;
+};
+
+template <class Handler>
+bool CborReader::Read(Handler& handler)
+{
+  Head head;
+  return ReadHead(head) && head.majorType == 6 && head.argument == 55799 &&  // self-describe tag
+    ReadItem(handler, nullptr, 0) && m_Data == m_End;
+}
+
+template <class Handler>
+bool CborReader::ReadItem(Handler& handler, const char* name, unsigned int depth)
+{
+  Head head;
+  if (depth > MAX_DEPTH || !ReadHead(head))
+  {
+    return false;
+  }
+
+  switch (head.majorType)
+  {
+  case 0: // unsigned integer
+    if (head.argument > UINT32_MAX)
+    {
+      return false;
+    }
+    handler.WriteValue(name, static_cast<unsigned int>(head.argument));
+    return true;
+
+  case 1: // negative integer, -1 - argument
+    if (head.argument > static_cast<uint64_t>(INT32_MAX))
+    {
+      return false;
+    }
+    handler.WriteValue(name, static_cast<int>(-1 - static_cast<int64_t>(head.argument)));
+    return true;
+
+  case 3: // text string
+  {
+    std::string value;
+    if (!ReadString(head, value))
+    {
+      return false;
+    }
+    handler.WriteValue(name, value.c_str());
+    return true;
+  }
+
+  case 4: // array
+    handler.WriteArray(name, false);
+    for (uint64_t i = 0; head.IsIndefinite() ? !IsBreak() : i < head.argument; ++i)
+    {
+      if (!ReadItem(handler, nullptr, depth + 1))
+      {
+        return false;
+      }
+    }
+    handler.CloseScope();
+    return true;
+
+  case 5: // map, with text string keys
+    handler.WriteObject(name, false);
+    for (uint64_t i = 0; head.IsIndefinite() ? !IsBreak() : i < head.argument; ++i)
+    {
+      Head keyHead;
+      std::string key;
+      if (!ReadHead(keyHead) || keyHead.majorType != 3 || !ReadString(keyHead, key) ||
+        !ReadItem(handler, key.c_str(), depth + 1))
+      {
+        return false;
+      }
+    }
+    handler.CloseScope();
+    return true;
+
+  case 7: // simple values and floats; the argument holds the bits of the latter.
+    switch (head.additionalInfo)
+    {
+    case 20:
+      handler.WriteValue(name, false);
+      return true;
+
+    case 21:
+      handler.WriteValue(name, true);
+      return true;
+
+    case 22:
+      handler.WriteValue(name, static_cast<const char*>(nullptr));
+      return true;
+
+    case 25: // half precision
+      handler.WriteValue(name, HalfToFloat(static_cast<uint16_t>(head.argument)));
+      return true;
+
+    case 26: // single precision
+    {
+      const uint32_t bits = static_cast<uint32_t>(head.argument);
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      handler.WriteValue(name, value);
+      return true;
+    }
+
+    case 27: // double precision
+    {
+      double value;
+      memcpy(&value, &head.argument, sizeof(value));
+      handler.WriteValue(name, value);
+      return true;
+    }
+    }
+    return false;
+
+  default:
+    return false;
+  }
+}
+
+#endif // CBORREADER_H
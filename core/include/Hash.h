@@ -0,0 +1,28 @@
+#ifndef HASH_H
+#define HASH_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+///@brief Calculates a fast, non-cryptographic, 64 bit hash (XXH64) of the
+/// @a size bytes at @a data. To hash data that isn't contiguous, pass the
+/// hash of the previous part as the @a seed of the next one.
+uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+#endif // HASH_H
@@ -17,13 +17,20 @@
  *
  */
 
+#include <cstdint>
 #include <sstream>
+#include <string>
 #include <vector>
 #include <cassert>
 
 ///@brief Facilitates the writing of a JSON document into a given std::ostream.
 /// Performs line breaks, indentation, and comma separation automatically.
-/// Does not perform additional caching; writes directly to the stream.
+/// Output is collected in an internal buffer, which is written to the stream
+/// when it fills up, on Flush(), and on destruction; call Flush() before writing
+/// to the stream directly.
+///
+/// Floating point values are written with the fewest significant digits that
+/// read back as the same value, at the precision they were passed with.
 ///
 /// The indentation is set with the string passed to the constructor.
 /// Line breaks on objects and arrays can be controlled with the oneLiner parameter
@@ -34,6 +41,16 @@
 ///   2.0,
 /// ]
 ///
+/// In compact mode, no insignificant whitespace is written at all; neither line
+/// breaks, nor indentation, nor spaces.
+///
+/// In binary mode, the same document is encoded as CBOR (RFC 7049), which is
+/// quicker to decode: it starts with the self-describe tag (0xd9d9f7), objects
+/// and arrays are indefinite length maps and arrays, strings are text strings,
+/// integers are the shortest of their encodings, and floating point values are
+/// half precision where that's exact, single or double precision otherwise.
+/// Refer to CborReader for decoding it.
+///
 /// Usage example:
 /// std::fstream myJsonFile("books.json"); // open stream
 /// JsonWriter w(myJsonFile, "\t"); // start writing, indent with a tab character (nothing is written yet)
@@ -49,13 +66,26 @@
 ///                                                              // |   "cooking": [
 /// w.CloseScope();                       // closes "cooking" array |   ]
 /// w.CloseScope();                          // closes root element | }
+/// w.Flush();                     // writes the buffered output to the stream
 /// myJsonFile << std::endl; // write an endl at the end of the file
 /// myJsonFile.close(); // finish writing the file
 ///
 class JsonWriter
 {
 public:
-  JsonWriter(std::ostream& stream, const char* indentation);
+  enum Format
+  {
+    PRETTY,
+    COMPACT,
+    BINARY,
+  };
+
+  ///@param indentation Only used in PRETTY format.
+  JsonWriter(std::ostream& stream, const char* indentation, Format format = PRETTY);
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
 
   ///@brief Opens an object scope.
   ///@param name If the parent scope is an array (or root) this must be null, otherwise
@@ -90,6 +120,12 @@ public:
   ///@param value the value to write.
   void WriteValue(const char* name, unsigned int value);
 
+  ///@brief Writes a single precision value.
+  ///@param name If the parent scope is an array this must be null, otherwise
+  /// this is the key. NOTE: special characters must be escaped manually.
+  ///@param value the value to write.
+  void WriteValue(const char* name, float value);
+
   ///@brief Writes a double precision value.
   ///@param name If the parent scope is an array this must be null, otherwise
   /// this is the key. NOTE: special characters must be escaped manually.
@@ -105,6 +141,9 @@ public:
   ///@brief Closes the currently written scope.
   void CloseScope();
 
+  ///@brief Writes the buffered output to the stream.
+  void Flush();
+
 private:
   struct Scope
   {
@@ -122,6 +161,22 @@ private:
   std::ostream& mStream;
   std::vector<Scope> mScopes;
   std::string mIndentation;
+  Format mFormat;
+  std::string mIndentations;  // mIndentation repeated for the deepest scope so far.
+  std::string mBuffer;
+
+  void Put(char c)
+  {
+    mBuffer.push_back(c);
+  }
+
+  void Put(const char* data, size_t size);
+  void Put(const char* str);
+
+  ///@brief Writes the head of a CBOR data item, with the shortest encoding of @a argument.
+  void PutCborHead(unsigned int majorType, uint64_t argument);
+  void PutCborFloat(float value);
+  void PutCborString(const char* str);
 
   void Comma();
   void Indent(bool oneLiner);
@@ -130,8 +185,11 @@ private:
 
   void WritePreamble(const char* name)
   {
-    Comma();
-    Indent(mScopes.empty() ? false : mScopes.back().isOneLiner);
+    if (mFormat != BINARY)
+    {
+      Comma();
+      Indent(mScopes.empty() ? false : mScopes.back().isOneLiner);
+    }
     Name(name);
   }
 };
@@ -18,19 +18,50 @@
  */
 
 #include "Scene3D.h"
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 using MeshIds = std::vector<unsigned int>;
 
+class WorkerPool;
+
+///@brief Index of the leaf nodes (ones with no meshes and no children) of an
+/// aiScene by name, which is what cameras and lights are attached to, and of
+/// the global transforms of all nodes. Built in a single pass over the hierarchy,
+/// which mustn't change while the index is in use.
+class SceneNodeIndex
+{
+public:
+  explicit SceneNodeIndex(const aiScene* scene);
+
+  ///@return The first leaf node named @a name, in depth first order, or nullptr.
+  const aiNode* FindLeafNamed(const std::string& name) const;
+
+  ///@return Whether @a node is a leaf with the name of one of the cameras.
+  bool IsCameraNode(const aiNode* node) const;
+
+  ///@return The transform of @a node, relative to the root of the scene.
+  const aiMatrix4x4& GetGlobalTransform(const aiNode* node) const;
+
+private:
+  void AddNode(const aiNode* node, const aiMatrix4x4& parentTransform);
+
+  std::unordered_map<std::string, const aiNode*> m_Leaves;
+  std::unordered_set<std::string> m_CameraNames;
+  std::unordered_map<const aiNode*, aiMatrix4x4> m_GlobalTransforms;
+};
+
 ///@brief Gets nodes from the aiScene and adds them to @a scene_data, except for
 /// camera nodes, which must have no children and no meshes, and match the name
-/// of a camera in aiScene.
+/// of a camera in aiScene, according to @a index.
 /// Dli nodes may have no more than 1 mesh; out of any aiNode's meshes, the
 /// first one is registered to the Dli node, then separate nodes are created with
 /// the rest of the meshes, and the same local transform, but with no name.
 /// The meshes are stored as indices into the mesh array of the aiScene. The
 /// indices of those actually used are written into the @a meshIds vector.
-void GetSceneNodes(Scene3D &scene_data, MeshIds& meshIds, Node3D *parent, const aiScene *scene, const aiNode *aNode);
+void GetSceneNodes(Scene3D &scene_data, MeshIds& meshIds, Node3D *parent, const aiScene *scene, const aiNode *aNode,
+    const SceneNodeIndex& index);
 
 ///@brief Meshes are registered on dli Node3Ds as indices into the mesh array
 /// of the aiScene. This function converts them into indices into @a meshIds,
@@ -38,11 +69,26 @@ void GetSceneNodes(Scene3D &scene_data, MeshIds& meshIds, Node3D *parent, const
 void PackSceneNodeMeshIds(Scene3D& scene_data, const MeshIds& meshIds);
 
 ///@brief Gets the meshes whose indices are recorded into @a meshIds, from
-/// the aiScene and creates Mesh entries into @a scene_data.
-void GetSceneMeshes(Scene3D& scene_data, const MeshIds& meshIds, const aiScene *scene);
+/// the aiScene and creates Mesh entries into @a scene_data. Their positions,
+/// normals and tangents are views of the arrays of the aiMeshes - which must
+/// therefore outlive their use - until they're modified; refer to VertexArray.
+///@param workers Optional; if provided, the meshes are converted on its
+/// threads. The results are merged in order, producing the same Scene3D as
+/// the serial conversion.
+///@param releaseSource Whether to release the vertex data, faces and bone
+/// weights of each aiMesh as soon as it's converted, to reduce the peak of
+/// memory use; the meshes then own copies of all of their data. The aiScene
+/// mustn't be converted again after this.
+void GetSceneMeshes(Scene3D& scene_data, const MeshIds& meshIds, const aiScene *scene, WorkerPool* workers = nullptr,
+    bool releaseSource = false);
+
+///@brief Adds the cameras of the aiScene to @a scene_data, with the global
+/// transform of the node of the same name, found via @a index.
+void GetSceneCameras( Scene3D &scene_data, const aiScene *scene, const SceneNodeIndex& index );
 
-void GetSceneCameras( Scene3D &scene_data, const aiScene *scene );
-void GetSceneLights( Scene3D& scene_data, const aiScene* scene );
+///@brief Adds the lights of the aiScene to @a scene_data, with the transform of
+/// the node of the same name, found via @a index.
+void GetSceneLights( Scene3D& scene_data, const aiScene* scene, const SceneNodeIndex& index );
 void GetAnimations( Scene3D &scene_data, const aiScene *scene );
 
 #endif // LOADSCENE_H
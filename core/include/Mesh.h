@@ -21,8 +21,13 @@
 #include "Vector2.h"
 #include "Vector3.h"
 #include "Vector4.h"
+#include "VertexArray.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 
+class Node3D;
+
 
 struct BlendShape
 {
@@ -33,14 +38,23 @@ struct BlendShape
     float m_Weight = 0.f;
 };
 
+///@brief A level of detail of a mesh: a simplified version of its triangles,
+/// which uses the same vertices.
+struct MeshLod
+{
+    std::vector<uint32_t> m_Indices;
+    float m_Error = 0.f;  ///< The greatest distance from the mesh, relative to its extent.
+};
+
 class Mesh
 {
 public:
-    std::vector<Vector3> m_Positions;
-    std::vector<Vector3> m_Normals;
-    std::vector<Vector3> m_Tangents;
+    VertexArray<Vector3> m_Positions; // may be views of the data of the importer; refer to GetSceneMeshes().
+    VertexArray<Vector3> m_Normals;
+    VertexArray<Vector3> m_Tangents;
     std::vector<Vector2> m_Textures;
-    std::vector<unsigned short> m_Indices;
+    std::vector<uint32_t> m_Indices; // written as 16 bits each if they all fit.
+    std::vector<MeshLod> m_Lods;     // in order of decreasing detail; refer to GenerateLods().
 
     std::vector<Vector4> m_Joints0; // indices into the joints of the skeleton (refer to Node3D::GetJoints()).
     std::vector<Vector4> m_Weights0;
@@ -55,6 +69,11 @@ public:
     {
       return m_Skeleton != nullptr;
     }
+
+    ///@brief Calculates the width and height of the texture needed to store
+    /// the blend shapes into, from the number of their positions, normals and
+    /// tangents.
+    void UpdateBlendShapeHeader();
 };
 
 #endif //MESH_H
@@ -0,0 +1,133 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Mesh.h"
+#include <memory>
+#include <vector>
+
+class Scene3D;
+class WorkerPool;
+
+///@return Whether the indices of @a mesh, and of its levels of detail, are all
+/// of vertices that it has. The functions below expect this of the meshes and
+/// indices that they're given; SplitMeshes() skips the meshes without it.
+bool HasValidIndices(const Mesh& mesh);
+
+///@brief The efficiency of the post transform vertex cache of the GPU, when
+/// drawing a list of triangles.
+struct VertexCacheStats
+{
+  float acmr = 0.f; ///< Average cache miss ratio: the number of vertices transformed per triangle; 0.5 at best.
+  float atvr = 0.f; ///< Average transformed vertex ratio: the number of times each vertex is transformed; 1 at best.
+};
+
+///@brief The size of the FIFO cache that AnalyzeVertexCache() simulates by
+/// default, which is typical of the mobile GPUs that we target.
+const unsigned int DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+///@brief Simulates a FIFO post transform cache of @a cacheSize vertices,
+/// while drawing the triangles of @a indices, into a buffer of @a numVertices.
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, unsigned int numVertices,
+  unsigned int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+///@brief Reorders the triangles of @a indices, into a buffer of @a numVertices,
+/// for the locality of their vertices, using Tom Forsyth's algorithm (Linear-
+/// speed vertex cache optimisation). This greedily picks the next triangle by
+/// the score of its vertices, which favours the ones that were recently used,
+/// and those with few triangles left to draw, so that they may be evicted. The
+/// order of the vertices within triangles is kept, and with it their winding.
+void OptimizeVertexCache(std::vector<uint32_t>& indices, unsigned int numVertices);
+
+///@brief The overdraw of drawing a list of triangles, as estimated by AnalyzeOverdraw().
+struct OverdrawStats
+{
+  unsigned int numCovered = 0;  ///< The number of pixels that the triangles cover.
+  unsigned int numShaded = 0;   ///< The number of times that pixels passed the depth test.
+  float overdraw = 0.f;         ///< numShaded / numCovered; 1 at best.
+};
+
+///@brief The width and height, in pixels, of the views that AnalyzeOverdraw()
+/// rasterizes into by default.
+const unsigned int DEFAULT_OVERDRAW_VIEW_SIZE = 256;
+
+///@brief The ratio of the ACMR (refer to VertexCacheStats) that OptimizeOverdraw()
+/// may take the triangles to, relative to their original order, by default.
+const float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+///@brief Estimates the overdraw of drawing the triangles of @a indices, into
+/// @a positions, in order. They're rasterized - on the CPU, with a depth test
+/// and back face culling (of clockwise triangles) - into an orthographic view
+/// along each of the positive and negative X, Y and Z axes, which is fit to
+/// the bounds of the mesh, and is @a viewSize pixels wide and high.
+OverdrawStats AnalyzeOverdraw(const std::vector<uint32_t>& indices, const VertexArray<Vector3>& positions,
+  unsigned int viewSize = DEFAULT_OVERDRAW_VIEW_SIZE);
+
+///@brief Reorders the triangles of @a indices, into @a positions, so that the
+/// ones which face outwards, and are therefore likely to occlude the rest from
+/// any direction, are drawn first (Sander et al., Fast Triangle Reordering for
+/// Vertex Locality and Reduced Overdraw). The triangles are split into clusters
+/// - which keep their order - where their ACMR wouldn't exceed @a threshold
+/// times the one of their current order; this should therefore come after
+/// OptimizeVertexCache(). A greater @a threshold makes smaller clusters, which
+/// may be sorted better, at the cost of the efficiency of the vertex cache.
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const VertexArray<Vector3>& positions,
+  float threshold = DEFAULT_OVERDRAW_THRESHOLD);
+
+///@brief Reorders the vertices of @a mesh to the order that they're first used
+/// in by its indices, which are remapped accordingly, so that the vertex fetches
+/// of drawing it are as local as they can be; this should therefore come after
+/// any reordering of the triangles. All per vertex data - including that of the
+/// skinning and the blend shapes - is reordered alike, and the levels of detail
+/// are remapped. Vertices that aren't used by any triangle are removed. Meshes
+/// without indices are left alone.
+///@return The number of vertices removed.
+unsigned int OptimizeVertexFetch(Mesh& mesh);
+
+///@brief Splits @a mesh into parts that each reference no more than
+/// @a maxVertices vertices, with their own, local vertex indices. Triangles
+/// keep their order; a new part is started whenever the next triangle would
+/// take the current one over the limit. All per vertex data - including that
+/// of the skinning and the blend shapes - is carried over.
+///@return The parts, or an empty vector if @a mesh didn't need splitting.
+std::vector<Mesh> SplitMesh(const Mesh& mesh, unsigned int maxVertices);
+
+///@brief Splits the meshes of @a scene that have more than @a maxVertices
+/// vertices (see SplitMesh()). The first part of a mesh takes its place; the
+/// rest are added to the end of the meshes, each referenced from a new child
+/// node (with an identity transform) of every node that used the original.
+/// Meshes with indices of vertices that they don't have are left alone.
+///@return The number of meshes that were split.
+unsigned int SplitMeshes(Scene3D& scene, unsigned int maxVertices);
+
+///@brief The results of DeduplicateMeshes().
+struct DeduplicationStats
+{
+  unsigned int numMeshes = 0;   ///< The number of meshes before.
+  unsigned int numUnique = 0;   ///< The number of meshes after.
+  size_t numBytesSaved = 0;     ///< The size of the vertex and index data of the meshes removed.
+};
+
+///@brief Removes the meshes of @a scene that are identical to an earlier one -
+/// in all of their vertex data, indices, levels of detail, skeleton and blend
+/// shapes - and points the nodes that used them to that one instead. Meshes are
+/// grouped by a hash of their contents, which is calculated on @a workers if
+/// provided, then compared in full. The rest of the meshes keep their order.
+DeduplicationStats DeduplicateMeshes(Scene3D& scene, WorkerPool* workers = nullptr);
+
+#endif // MESHOPTIMIZER_H
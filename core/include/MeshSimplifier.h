@@ -0,0 +1,49 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Mesh.h"
+#include <vector>
+
+///@brief Simplifies the triangles of @a indices, into the vertices of @a mesh,
+/// towards @a targetNumIndices, by collapsing edges in the order of their
+/// quadric error (Garland & Heckbert, Surface Simplification Using Quadric
+/// Error Metrics). A vertex is only ever collapsed onto a neighbour, so the
+/// result uses the vertices of @a mesh, with no new ones.
+/// The differences of the normals, texture coordinates and skin weights of
+/// the vertices add to the error. Vertices that share their position with
+/// others - i.e. are on a UV or normal seam - are never moved; those on the
+/// border of the mesh only move along it. Collapses that would flip triangles
+/// are rejected. The indices must be of vertices of @a mesh (refer to
+/// HasValidIndices()).
+///@param error Output: the greatest error of the collapses, as a distance
+/// relative to the extent of the mesh.
+///@return The simplified indices; no fewer than @a targetNumIndices, if the
+/// target couldn't be reached.
+std::vector<uint32_t> SimplifyIndices(const Mesh& mesh, const std::vector<uint32_t>& indices,
+  size_t targetNumIndices, float& error);
+
+///@brief Generates up to @a numLods levels of detail of @a mesh into its m_Lods,
+/// each simplified (refer to SimplifyIndices()) from the previous one, with
+/// @a ratio of its triangles. The error of each level is the sum of those of
+/// the simplifications that led to it. Generation stops at the first level
+/// that couldn't be simplified.
+///@return The number of levels generated.
+unsigned int GenerateLods(Mesh& mesh, unsigned int numLods, float ratio);
+
+#endif // MESHSIMPLIFIER_H
@@ -0,0 +1,43 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+///@brief Interns names, and makes a valid version of each distinct one (see
+/// Node3D::MakeValidName()) exactly once, so that writers may refer to them by
+/// id rather than making them valid on each use.
+class NameTable
+{
+public:
+  enum : unsigned int { INVALID_ID = static_cast<unsigned int>(-1) };
+
+  ///@return The id of @a name, which is stable for the lifetime of the table.
+  unsigned int Intern(const std::string& name);
+
+  ///@return The valid version of the name interned as @a id.
+  const std::string& GetValidName(unsigned int id) const;
+
+private:
+  std::unordered_map<std::string, unsigned int> m_Ids;
+  std::vector<std::string> m_ValidNames;
+};
+
+#endif // NAMETABLE_H
@@ -34,9 +34,71 @@ class Node3D
 public:
     enum { INVALID_MESH = -1 };
 
+    ///@brief The children of a node, in the order that they were added, linked
+    /// through their m_NextSibling, so that they need no storage of their own.
+    class ChildList
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            explicit const_iterator(Node3D* node)
+            : m_Node(node)
+            {}
+
+            Node3D* operator*() const
+            {
+                return m_Node;
+            }
+
+            const_iterator& operator++()
+            {
+                m_Node = m_Node->m_NextSibling;
+                return *this;
+            }
+
+            bool operator!=(const const_iterator& other) const
+            {
+                return m_Node != other.m_Node;
+            }
+
+        private:
+            Node3D* m_Node;
+        };
+
+        const_iterator begin() const
+        {
+            return const_iterator(m_First);
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(nullptr);
+        }
+
+        size_t size() const
+        {
+            return m_Size;
+        }
+
+        bool empty() const
+        {
+            return m_Size == 0;
+        }
+
+        void push_back(Node3D* node);
+
+    private:
+        Node3D* m_First = nullptr;
+        Node3D* m_Last = nullptr;
+        size_t m_Size = 0;
+    };
+
     using Predicate = std::function<bool(const Node3D&)>;
     static const Predicate DEFAULT_END_VISIT_PREDICATE;
 
+    ///@return @a name with whitespace and colons replaced with underscores.
+    ///@note Consider NameTable, which only does this once per distinct name.
     static std::string MakeValidName(const std::string & name);
 
     Node3D(Node3D *eParent);
@@ -67,12 +129,14 @@ public:
 
     unsigned int m_Index;
     string m_Name;
+    unsigned int m_NameId; // into the names of the Scene3D that the node is added to.
     Node3D *m_Parent;
     Matrix m_Matrix;
     int m_MaterialIdx;
     bool m_isBlendEnabled;
 
-    vector<Node3D*> m_Children;
+    ChildList m_Children;
+    Node3D* m_NextSibling = nullptr;
     unsigned int m_MeshId = INVALID_MESH;
 
     Node3D* m_Skeleton; // no ownership; shows which skeleton this node is a part of (if not nullptr).
@@ -85,7 +149,7 @@ private:
         v(n);
         if (!endVisitPredicate(n))
         {
-            for (auto& i : n.m_Children)
+            for (auto i : n.m_Children)
             {
                 i->Visit(v);
             }
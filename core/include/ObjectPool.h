@@ -0,0 +1,102 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///@brief Owns objects of type T, which it creates in blocks of memory, of
+/// doubling capacity, rather than allocating each of them separately. The
+/// objects don't move, and are only destroyed along with the pool, in the
+/// reverse order of their creation, after which the blocks are freed.
+template <typename T>
+class ObjectPool
+{
+public:
+  ObjectPool() = default;
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  ~ObjectPool()
+  {
+    for (auto iBlock = m_Blocks.rbegin(); iBlock != m_Blocks.rend(); ++iBlock)
+    {
+      T* objects = reinterpret_cast<T*>(iBlock->storage.get());
+      for (size_t i = iBlock->size; i > 0; --i)
+      {
+        objects[i - 1].~T();
+      }
+    }
+  }
+
+  ///@brief Creates an object from @a args, in the current block, or a new one
+  /// if that's full.
+  template <typename... Args>
+  T* Create(Args&&... args)
+  {
+    if (m_Blocks.empty() || m_Blocks.back().size == m_Blocks.back().capacity)
+    {
+      size_t capacity = m_Blocks.empty() ? MIN_BLOCK_CAPACITY : m_Blocks.back().capacity * 2;
+      if (capacity > MAX_BLOCK_CAPACITY)
+      {
+        capacity = MAX_BLOCK_CAPACITY;
+      }
+      m_Blocks.push_back({ std::unique_ptr<Storage[]>(new Storage[capacity]), capacity, 0 });
+    }
+
+    auto& block = m_Blocks.back();
+    T* object = new (block.storage.get() + block.size) T(std::forward<Args>(args)...);
+    ++block.size;
+    ++m_NumObjects;
+    return object;
+  }
+
+  ///@return The number of objects created.
+  size_t GetNumObjects() const
+  {
+    return m_NumObjects;
+  }
+
+  ///@return The number of blocks of memory allocated.
+  size_t GetNumBlocks() const
+  {
+    return m_Blocks.size();
+  }
+
+private:
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  static const size_t MIN_BLOCK_CAPACITY = 16;
+  static const size_t MAX_BLOCK_CAPACITY = 4096;
+
+  struct Block
+  {
+    std::unique_ptr<Storage[]> storage;
+    size_t capacity;
+    size_t size;  // the number of objects created in it.
+  };
+
+  std::vector<Block> m_Blocks;
+  size_t m_NumObjects = 0;
+};
+
+#endif // OBJECTPOOL_H
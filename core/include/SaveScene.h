@@ -18,8 +18,35 @@
  */
 
 #include "Scene3D.h"
+#include "VertexEncoding.h"
 #include <map>
 
+class WorkerPool;
+
+///@brief Options for the output of ConvertScene().
+struct SaveOptions
+{
+  bool compact = false; // no insignificant whitespace in the .dli.
+  bool binary = false;  // the .dli in the binary (CBOR) format of JsonWriter; overrides compact.
+  bool deduplicateMeshes = false;   // remove meshes identical to an earlier one; refer to DeduplicateMeshes().
+  bool shortIndices = false;  // split meshes as needed for all indices to fit 16 bits; refer to SplitMeshes().
+  bool optimizeVertexCache = false; // reorder the triangles of meshes for the post transform cache; refer to OptimizeVertexCache().
+  bool optimizeOverdraw = false;    // reorder clusters of triangles of meshes to reduce overdraw; refer to OptimizeOverdraw().
+  float overdrawThreshold = 1.05f;  // the ACMR that OptimizeOverdraw() may go to, relative to the triangles' current order.
+  bool optimizeVertexFetch = false; // reorder the vertices of meshes to the order of their first use; refer to OptimizeVertexFetch().
+  VertexEncoding::Type positionEncoding = VertexEncoding::FLOAT32;  // FLOAT32 or UNORM16.
+  VertexEncoding::Type normalEncoding = VertexEncoding::FLOAT32;    // of normals and tangents; FLOAT32, OCT16 or OCT8.
+  VertexEncoding::Type textureEncoding = VertexEncoding::FLOAT32;   // FLOAT32, UNORM16 or HALF.
+  unsigned int numLods = 0;         // the number of levels of detail to generate for each mesh; refer to GenerateLods().
+  float lodRatio = 0.5f;            // the ratio of the triangles of each level of detail to the previous one.
+  bool interleaved = false;         // the attributes of each mesh in a single, interleaved "vertices" buffer.
+  bool separatePositions = false;   // with interleaved, the positions in their own buffer, i.e. for depth passes.
+  bool constantAttributes = false;  // attributes with the same value for every vertex as that value, rather than a buffer.
+  bool shareBuffers = false;        // buffers identical to one written earlier reference it, rather than being written again.
+  unsigned int bufferAlignment = 1; // of the offset of each buffer (but those interleaved) in the .bin; a power of two.
+  size_t memoryBudget = 0;          // for the meshes being encoded at once, in bytes; each is emptied once written. 0 is unlimited.
+};
+
 /**
  * @brief Saves the given @a scene to the given absolute paths for the .dli and
  *        .bin files.
@@ -40,10 +67,24 @@ bool SaveScene(Scene3D* scene, std::string dliOutputPath,
  *        was set, the pair of names & content byte buffers of animation files
  *        will be registered into it instead of saved to the filesystem (into
  *        the folder which is the parent of @a fileNameBin).
+ * @param workers Optional; if provided, the binary data of the meshes is
+ *        encoded on its threads, before being written in order.
+ * @param options Refer to SaveOptions.
+ * @note The indices of each mesh are written as 16 bits if they fit, and as 32
+ *       bits otherwise, which is recorded in its flags. Attributes that aren't
+ *       32 bit floats have their encoding recorded in their buffer, along with
+ *       the offset and scale of their components, if UNORM16. Interleaved
+ *       attributes record the byteStride between their elements. Levels of
+ *       detail are written as extra index buffers, with the same width. With
+ *       constantAttributes, attributes that are the same for every vertex
+ *       are written as a "value", with no buffer. A bufferAlignment other than
+ *       1 is recorded in the "asset". The output doesn't depend on the
+ *       memoryBudget.
  * @return The success of the operation.
  */
 bool ConvertScene(Scene3D* scene, std::string fileNameBin, std::ostream& outDli,
     std::ostream& outBin, bool saveMaterials, bool binaryAnimations = true,
-    std::map<std::string, std::string>* animationContents = nullptr);
+    std::map<std::string, std::string>* animationContents = nullptr,
+    WorkerPool* workers = nullptr, const SaveOptions& options = SaveOptions());
 
 #endif // SAVESCENE_H
@@ -21,12 +21,14 @@
 #include "Camera3D.h"
 #include "Light.h"
 #include "Animation3D.h"
+#include "Mesh.h"
+#include "NameTable.h"
+#include "ObjectPool.h"
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 
-class Mesh;
-
 class Scene3D
 {
     public:
@@ -38,11 +40,22 @@ class Scene3D
         unsigned int GetNumCameras() const;
         unsigned int GetNumLights() const;
         unsigned int GetNumAnimations() const;
+        ///@brief Creates a node, owned by the scene, as the last child of @a parent,
+        /// if any. It's only indexed once it's added.
+        Node3D* CreateNode(Node3D* parent);
+        ///@brief Indexes @a enode, which was created by CreateNode(), and interns
+        /// its name, which must not change after this.
         void AddNode(Node3D *enode);
         Node3D* GetNode(unsigned int idx);
+        ///@return The first node added with the given @a name, or nullptr.
         Node3D* FindNodeNamed(const std::string& name) const;
-        void AddMesh(Mesh* emesh);
+        ///@brief Moves @a emesh into a mesh owned by the scene, at the end of its meshes.
+        Mesh* AddMesh(Mesh&& emesh);
         Mesh* GetMesh(unsigned int idx) const;
+        ///@brief Removes - and releases the data of - the meshes for which
+        /// @a remove is set, moving the rest down in their place, in order.
+        /// The mesh ids of nodes aren't updated.
+        void RemoveMeshes(const std::vector<bool>& remove);
         void AddSkeletonRoot(Node3D* node);
         Node3D* GetSkeletonRoot(unsigned int idx) const;
         unsigned int FindSkeletonId(const Node3D* skeletonRoot) const;
@@ -50,18 +63,29 @@ class Scene3D
         Camera3D* GetCamera(unsigned int idx);
         void AddLight(const Light& eLight);
         Light* GetLight(unsigned int idx);
+        ///@brief Adds a copy of @a eanim, interning the names of the nodes it animates.
         void AddAnimation(Animation3D &eanim);
         bool HasAnimations();
         Animation3D* GetAnimation(unsigned int idx);
+        ///@return The valid version of the name of a node or animated node,
+        /// by its id (refer to Node3D::m_NameId and NodeAnimation3D::NodeNameId).
+        const std::string& GetValidName(unsigned int nameId) const;
+        ///@return The number of blocks of memory that the nodes and meshes
+        /// have been created in.
+        unsigned int GetNumAllocations() const;
     protected:
 
     private:
+        ObjectPool<Node3D> m_nodePool;
+        ObjectPool<Mesh> m_meshPool;
         vector<Node3D*> m_nodes;
-        vector<Mesh*> m_meshes;
+        unordered_map<std::string, Node3D*> m_nodeNames;   // the first of m_nodes with each name.
+        vector<Mesh*> m_meshes;             // no ownership; references m_meshPool.
         vector<Node3D*> m_skeletonRoots;    // no ownership; references m_nodes.
         vector<Camera3D> m_cameras;
         vector<Light> m_lights;
         vector<Animation3D> m_animations;
+        NameTable m_names;
 };
 
 #endif // SCENE3D_H
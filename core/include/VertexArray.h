@@ -0,0 +1,176 @@
+#ifndef VERTEXARRAY_H
+#define VERTEXARRAY_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+///@brief An array of per vertex data, which either owns its elements, or is a
+/// view of ones owned elsewhere - i.e. by the importer - which it copies the
+/// first time that it's accessed for modifying them. Only the const accessors
+/// leave a view as it is. A copy of a view is a view of the same elements.
+template <typename T>
+class VertexArray
+{
+public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  VertexArray() = default;
+
+  VertexArray(std::vector<T>&& elements)
+  : m_Elements(std::move(elements))
+  {}
+
+  VertexArray(const VertexArray&) = default;
+  VertexArray& operator=(const VertexArray&) = default;
+
+  VertexArray(VertexArray&& other)
+  : m_Elements(std::move(other.m_Elements)),
+    m_View(other.m_View),
+    m_ViewSize(other.m_ViewSize)
+  {
+    other.m_View = nullptr;
+    other.m_ViewSize = 0;
+  }
+
+  VertexArray& operator=(VertexArray&& other)
+  {
+    m_Elements = std::move(other.m_Elements);
+    m_View = other.m_View;
+    m_ViewSize = other.m_ViewSize;
+    other.m_View = nullptr;
+    other.m_ViewSize = 0;
+    return *this;
+  }
+
+  ///@brief Makes this a view of the @a size elements at @a elements, which
+  /// must outlive it, or until it's modified.
+  void SetView(const T* elements, size_t size)
+  {
+    std::vector<T>().swap(m_Elements);
+    m_View = elements;
+    m_ViewSize = size;
+  }
+
+  bool IsView() const
+  {
+    return m_View != nullptr;
+  }
+
+  size_t size() const
+  {
+    return m_View ? m_ViewSize : m_Elements.size();
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  const T* data() const
+  {
+    return m_View ? m_View : m_Elements.data();
+  }
+
+  const T& operator[](size_t i) const
+  {
+    return data()[i];
+  }
+
+  const_iterator begin() const
+  {
+    return data();
+  }
+
+  const_iterator end() const
+  {
+    return data() + size();
+  }
+
+  T* data()
+  {
+    return Elements().data();
+  }
+
+  T& operator[](size_t i)
+  {
+    return Elements()[i];
+  }
+
+  iterator begin()
+  {
+    return data();
+  }
+
+  iterator end()
+  {
+    return data() + size();
+  }
+
+  void reserve(size_t capacity)
+  {
+    Elements().reserve(capacity);
+  }
+
+  void resize(size_t size, const T& value = T())
+  {
+    Elements().resize(size, value);
+  }
+
+  void push_back(const T& value)
+  {
+    Elements().push_back(value);
+  }
+
+  template <typename Iterator>
+  void assign(Iterator first, Iterator last)
+  {
+    m_View = nullptr;
+    m_ViewSize = 0;
+    m_Elements.assign(first, last);
+  }
+
+  void clear()
+  {
+    m_View = nullptr;
+    m_ViewSize = 0;
+    m_Elements.clear();
+  }
+
+private:
+  ///@return The elements, which are copied first if this was a view.
+  std::vector<T>& Elements()
+  {
+    if (m_View)
+    {
+      m_Elements.assign(m_View, m_View + m_ViewSize);
+      m_View = nullptr;
+      m_ViewSize = 0;
+    }
+    return m_Elements;
+  }
+
+  std::vector<T> m_Elements;
+  const T* m_View = nullptr;
+  size_t m_ViewSize = 0;
+};
+
+#endif // VERTEXARRAY_H
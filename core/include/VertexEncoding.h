@@ -0,0 +1,77 @@
+#ifndef VERTEXENCODING_H
+#define VERTEXENCODING_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Vector3.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+///@brief The encodings that the vertex attributes of meshes may be written in.
+struct VertexEncoding
+{
+  enum Type
+  {
+    FLOAT32,  ///< 32 bit floats, per component.
+    UNORM16,  ///< 16 bit normalized unsigned integers, per component, within the bounds of the values; refer to VertexQuantization.
+    HALF,     ///< 16 bit floats, per component.
+    OCT16,    ///< unit vectors mapped onto an octahedron, as 2 x 16 bit normalized signed integers.
+    OCT8,     ///< unit vectors mapped onto an octahedron, as 2 x 8 bit normalized signed integers.
+  };
+
+  ///@return The name of @a type, as written to the .dli, i.e. "UNORM16".
+  static const char* GetName(Type type);
+
+  ///@brief Finds the encoding called @a name, case insensitively.
+  ///@return Whether there was one.
+  static bool FromName(const std::string& name, Type& type);
+};
+
+///@brief The transform from the UNORM16 encoding of values back to their
+/// original range: each component is offset + scale * n, where n is the
+/// normalized, [0, 1] value.
+struct VertexQuantization
+{
+  unsigned int numComponents = 0;
+  float offset[4];
+  float scale[4];
+};
+
+///@brief Encodes the @a count elements of @a numComponents (up to 4) floats at
+/// @a values as UNORM16, into @a target, mapping the range of each component
+/// to [0, 1] by @a quantization.
+///@return The greatest absolute error of a component.
+float EncodeUnorm16(const float* values, size_t count, unsigned int numComponents, VertexQuantization& quantization,
+  char* target);
+
+///@brief Encodes the @a count floats at @a values as 16 bit floats, into @a target.
+///@return The greatest absolute error of a value.
+float EncodeHalf(const float* values, size_t count, char* target);
+
+///@brief Encodes the @a count unit @a vectors as OCT16 (@a bits of 16) or
+/// OCT8 (@a bits of 8), into @a target.
+///@return The greatest error of the direction of a vector, in degrees.
+float EncodeOctahedral(const Vector3* vectors, size_t count, unsigned int bits, char* target);
+
+///@return The 16 bit float closest to @a value.
+uint16_t FloatToHalf(float value);
+
+///@return The value of the 16 bit float @a half.
+float HalfToFloat(uint16_t half);
+
+#endif // VERTEXENCODING_H
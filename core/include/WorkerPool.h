@@ -0,0 +1,92 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///@brief A fixed set of threads which execute indexed tasks, i.e. the body of
+/// a parallel for loop. Each worker is handed a contiguous range of indices up
+/// front; once it has run out, it steals from the back of the other workers'
+/// ranges, so that a few expensive items don't hold up the rest.
+/// The thread calling Run() participates as the first worker; a pool of one
+/// thread therefore executes everything serially, on the calling thread.
+///@note Run() must not be called concurrently, or from within a task.
+class WorkerPool
+{
+public:
+  using Task = std::function<void(unsigned int)>;
+
+  ///@return The number of threads that the hardware supports, or 1 if that
+  /// could not be determined.
+  static unsigned int GetDefaultNumThreads();
+
+  ///@brief Executes @a task for each index in [0, numTasks), on @a workers if
+  /// provided, otherwise serially, on the calling thread.
+  static void Execute(WorkerPool* workers, unsigned int numTasks, const Task& task);
+
+  ///@param numThreads The total number of threads to execute tasks on,
+  /// including the caller of Run(). 0 means GetDefaultNumThreads().
+  explicit WorkerPool(unsigned int numThreads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  unsigned int GetNumThreads() const;
+
+  ///@brief Executes @a task for each index in [0, numTasks), returning once
+  /// all of them have completed. The order of execution is unspecified.
+  /// If a task throws, the tasks that haven't started yet are skipped, and
+  /// the first exception is rethrown once the ones that have are finished.
+  void Run(unsigned int numTasks, const Task& task);
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<unsigned int> indices;
+  };
+
+  void WorkerMain(unsigned int workerIndex);
+  void Work(unsigned int workerIndex);
+  bool Pop(unsigned int workerIndex, unsigned int& outIndex);
+  bool Steal(unsigned int workerIndex, unsigned int& outIndex);
+
+  std::vector<std::unique_ptr<Queue>> m_Queues; // one per worker, including the caller of Run().
+  std::vector<std::thread> m_Threads;
+  const Task* m_Task = nullptr;
+  std::atomic<unsigned int> m_Pending;
+  std::atomic<bool> m_Failed;
+  std::exception_ptr m_Exception; // the first thrown by a task; guarded by m_Mutex.
+
+  std::mutex m_Mutex;
+  std::condition_variable m_WakeCondition;
+  std::condition_variable m_DoneCondition;
+  unsigned int m_Generation = 0;
+  bool m_Quit = false;
+};
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "CborReader.h"
+
+CborReader::CborReader(const char* data, size_t size)
+: m_Data(data),
+  m_End(data + size)
+{}
+
+bool CborReader::ReadHead(Head& head)
+{
+  if (m_Data == m_End)
+  {
+    return false;
+  }
+
+  const uint8_t initialByte = static_cast<uint8_t>(*m_Data++);
+  head.majorType = initialByte >> 5;
+  head.additionalInfo = initialByte & 0x1f;
+  if (head.additionalInfo < 24)
+  {
+    head.argument = head.additionalInfo;
+    return true;
+  }
+
+  if (head.additionalInfo == 31)
+  {
+    // Indefinite length; only for arrays and maps here.
+    head.argument = 0;
+    return head.majorType == 4 || head.majorType == 5;
+  }
+
+  if (head.additionalInfo > 27)
+  {
+    return false;
+  }
+
+  // 24 - 27 mean 1, 2, 4 and 8 bytes of argument, most significant first.
+  const unsigned int numBytes = 1 << (head.additionalInfo - 24);
+  if (static_cast<size_t>(m_End - m_Data) < numBytes)
+  {
+    return false;
+  }
+
+  head.argument = 0;
+  for (unsigned int i = 0; i < numBytes; ++i)
+  {
+    head.argument = (head.argument << 8) | static_cast<uint8_t>(*m_Data++);
+  }
+  return true;
+}
+
+bool CborReader::ReadString(const Head& head, std::string& str)
+{
+  if (head.IsIndefinite() || head.argument > static_cast<uint64_t>(m_End - m_Data))
+  {
+    return false;
+  }
+
+  str.assign(m_Data, head.argument);
+  m_Data += head.argument;
+  return true;
+}
+
+bool CborReader::IsBreak()
+{
+  if (m_Data != m_End && *m_Data == '\xff')
+  {
+    ++m_Data;
+    return true;
+  }
+  return false;
+}
+
+float CborReader::HalfToFloat(uint16_t half)
+{
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f)
+  {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  }
+  else if (exponent != 0)
+  {
+    bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  }
+  else if (mantissa == 0)
+  {
+    bits = sign;
+  }
+  else
+  {
+    // Subnormal half; normalize it.
+    uint32_t shift = 0;
+    while ((mantissa & 0x400) == 0)
+    {
+      mantissa <<= 1;
+      ++shift;
+    }
+    bits = sign | ((127 - 15 + 1 - shift) << 23) | ((mantissa & 0x3ff) << 13);
+  }
+
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "Hash.h"
+#include <cstring>
+
+namespace
+{
+const uint64_t PRIME1 = 11400714785074694791ULL;
+const uint64_t PRIME2 = 14029467366897019727ULL;
+const uint64_t PRIME3 = 1609587929392839161ULL;
+const uint64_t PRIME4 = 9650029242287828579ULL;
+const uint64_t PRIME5 = 2870177450012600261ULL;
+
+inline uint64_t RotateLeft(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t Read64(const unsigned char* p)
+{
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Read32(const unsigned char* p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t Round(uint64_t accumulator, uint64_t input)
+{
+  accumulator += input * PRIME2;
+  accumulator = RotateLeft(accumulator, 31);
+  return accumulator * PRIME1;
+}
+
+inline uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+{
+  accumulator ^= Round(0, value);
+  return accumulator * PRIME1 + PRIME4;
+}
+}
+
+uint64_t Hash64(const void* data, size_t size, uint64_t seed)
+{
+  // NOTE: assumes little endian, which is all that we're building for.
+  auto p = static_cast<const unsigned char*>(data);
+  const unsigned char* const end = p + size;
+
+  uint64_t hash;
+  if (size >= 32)
+  {
+    uint64_t v1 = seed + PRIME1 + PRIME2;
+    uint64_t v2 = seed + PRIME2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME1;
+
+    const unsigned char* const limit = end - 32;
+    do
+    {
+      v1 = Round(v1, Read64(p));
+      v2 = Round(v2, Read64(p + 8));
+      v3 = Round(v3, Read64(p + 16));
+      v4 = Round(v4, Read64(p + 24));
+      p += 32;
+    }
+    while (p <= limit);
+
+    hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+    hash = MergeRound(hash, v1);
+    hash = MergeRound(hash, v2);
+    hash = MergeRound(hash, v3);
+    hash = MergeRound(hash, v4);
+  }
+  else
+  {
+    hash = seed + PRIME5;
+  }
+
+  hash += static_cast<uint64_t>(size);
+
+  while (p + 8 <= end)
+  {
+    hash ^= Round(0, Read64(p));
+    hash = RotateLeft(hash, 27) * PRIME1 + PRIME4;
+    p += 8;
+  }
+
+  if (p + 4 <= end)
+  {
+    hash ^= static_cast<uint64_t>(Read32(p)) * PRIME1;
+    hash = RotateLeft(hash, 23) * PRIME2 + PRIME3;
+    p += 4;
+  }
+
+  while (p < end)
+  {
+    hash ^= (*p) * PRIME5;
+    hash = RotateLeft(hash, 11) * PRIME1;
+    ++p;
+  }
+
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+  return hash;
+}
@@ -15,11 +15,269 @@
  *
  */
 #include "JsonWriter.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 
-JsonWriter::JsonWriter(std::ostream & stream, const char* indentation)
+namespace
+{
+
+const size_t BUFFER_SIZE = 1 << 16;
+
+namespace Cbor
+{
+const unsigned int UNSIGNED_INTEGER = 0;
+const unsigned int NEGATIVE_INTEGER = 1;
+const unsigned int TEXT_STRING = 3;
+const unsigned int TAG = 6;
+
+const uint64_t SELF_DESCRIBE_TAG = 55799;
+
+const char INDEFINITE_ARRAY = '\x9f';
+const char INDEFINITE_MAP = '\xbf';
+const char FALSE = '\xf4';
+const char TRUE = '\xf5';
+const char NULL_VALUE = '\xf6';
+const char HALF = '\xf9';
+const char SINGLE = '\xfa';
+const char DOUBLE = '\xfb';
+const char BREAK = '\xff';
+}
+
+///@brief Converts @a value to half precision, if that's exact (not considering
+/// subnormal halves).
+///@return Whether the conversion was exact, and @a half was set.
+bool ToHalf(float value, uint16_t& half)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const int exponent = static_cast<int>((bits >> 23) & 0xff);
+  const uint32_t mantissa = bits & 0x7fffff;
+  if (exponent == 0 && mantissa == 0)
+  {
+    half = sign;
+    return true;
+  }
+
+  if (exponent == 0xff)
+  {
+    half = sign | 0x7c00 | (mantissa ? 0x200 : 0);  // infinity, or the quiet NaN.
+    return true;
+  }
+
+  const int halfExponent = exponent - 127 + 15;
+  if (halfExponent < 1 || halfExponent > 30 || (mantissa & 0x1fff) != 0)
+  {
+    return false;
+  }
+
+  half = sign | (halfExponent << 10) | (mantissa >> 13);
+  return true;
+}
+
+///@brief Writes the @a numBytes low order bytes of @a value, most significant first.
+void PutBigEndian(uint64_t value, unsigned int numBytes, char* buffer)
+{
+  for (unsigned int i = 0; i < numBytes; ++i)
+  {
+    buffer[i] = static_cast<char>(value >> ((numBytes - 1 - i) * 8));
+  }
+}
+
+///@brief Writes the @a numDigits decimal digits of @a digits (without trailing
+/// zeroes), the first of which is at the given power of ten, in the style of
+/// %g (at a precision of @a numDigits).
+///@return The length of the result.
+int FormatDigits(bool negative, uint64_t digits, int numDigits, int exponent, char* buffer)
+{
+  char digitChars[20];
+  for (int i = numDigits - 1; i >= 0; --i)
+  {
+    digitChars[i] = '0' + digits % 10;
+    digits /= 10;
+  }
+
+  char* p = buffer;
+  if (negative)
+  {
+    *p++ = '-';
+  }
+
+  if (exponent < -4 || exponent >= numDigits)
+  {
+    *p++ = digitChars[0];
+    if (numDigits > 1)
+    {
+      *p++ = '.';
+      memcpy(p, digitChars + 1, numDigits - 1);
+      p += numDigits - 1;
+    }
+    p += sprintf(p, "e%c%02d", exponent < 0 ? '-' : '+', std::abs(exponent));
+  }
+  else if (exponent < 0)
+  {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > exponent; --i)
+    {
+      *p++ = '0';
+    }
+    memcpy(p, digitChars, numDigits);
+    p += numDigits;
+  }
+  else
+  {
+    memcpy(p, digitChars, exponent + 1);
+    p += exponent + 1;
+    if (numDigits > exponent + 1)
+    {
+      *p++ = '.';
+      memcpy(p, digitChars + exponent + 1, numDigits - exponent - 1);
+      p += numDigits - exponent - 1;
+    }
+  }
+  return p - buffer;
+}
+
+///@return 10 to the power of @a exponent, which must be within the range of
+/// exponents required for formatting floats.
+double GetPowerOf10(int exponent)
+{
+  const int MIN_EXPONENT = -64;
+  const int MAX_EXPONENT = 64;
+  static const std::vector<double> powers = []() {
+    std::vector<double> powers;
+    for (int i = MIN_EXPONENT; i <= MAX_EXPONENT; ++i)
+    {
+      powers.push_back(std::pow(10.0, i));
+    }
+    return powers;
+  }();
+  assert(exponent >= MIN_EXPONENT && exponent <= MAX_EXPONENT);
+  return powers[exponent - MIN_EXPONENT];
+}
+
+///@brief Formats @a value, in the style of %g, with the fewest significant
+/// digits that parse back as the same float.
+///@return The length of the result.
+int FormatFloat(float value, char* buffer, size_t bufferSize)
+{
+  if (!std::isfinite(value))
+  {
+    return snprintf(buffer, bufferSize, "%g", value);
+  }
+
+  // Integers are common, e.g. in the identity parts of matrices.
+  if (std::abs(value) < 1e7f && value == std::floor(value))
+  {
+    const bool isNegativeZero = value == 0.f && std::signbit(value);
+    return snprintf(buffer, bufferSize, isNegativeZero ? "-0" : "%d", static_cast<int>(value));
+  }
+
+  // Any decimal strictly within half a float ulp either side of the value reads
+  // back as it. Doubles represent these bounds exactly, and the decimal candidates
+  // to within much less than the bounds are apart - a margin takes care of that.
+  const double magnitude = std::abs(value);
+  // For FLT_MAX, the next float up is infinity; decimals from half an ulp above
+  // it read back as that.
+  const double lower = (magnitude + std::nextafter(std::abs(value), 0.f)) * .5;
+  const float next = std::nextafter(std::abs(value), HUGE_VALF);
+  const double upper = std::isinf(next) ? magnitude + std::ldexp(1.0, std::numeric_limits<float>::max_exponent - 1 -
+    std::numeric_limits<float>::digits) : (magnitude + next) * .5;
+  const double margin = magnitude * 1e-14;
+
+  int exponent = static_cast<int>(std::floor(std::log10(magnitude)));
+  if (GetPowerOf10(exponent) > magnitude)
+  {
+    --exponent;
+  }
+  else if (GetPowerOf10(exponent + 1) <= magnitude)
+  {
+    ++exponent;
+  }
+
+  // Find the fewest digits, whose nearest decimal to the value is within the
+  // bounds; 9 are always enough.
+  for (int numDigits = 1; ; ++numDigits)
+  {
+    const int scaleExponent = numDigits - 1 - exponent;
+    uint64_t digits = static_cast<uint64_t>(std::llround(magnitude * GetPowerOf10(scaleExponent)));
+    const double candidate = digits * GetPowerOf10(-scaleExponent);
+    const bool isInside = candidate > lower + margin && candidate < upper - margin;
+
+    // Ties with the bounds round to even, so may or may not read back as the
+    // value; these are rare enough to just try.
+    const bool isTie = !isInside && (std::abs(candidate - lower) <= margin || std::abs(candidate - upper) <= margin);
+    if (isInside || isTie || numDigits == 9)
+    {
+      int formatExponent = exponent;
+      int formatDigits = numDigits;
+
+      // Rounding may have carried over into an extra digit.
+      if (digits == static_cast<uint64_t>(GetPowerOf10(numDigits)))
+      {
+        digits /= 10;
+        ++formatExponent;
+      }
+
+      while (formatDigits > 1 && digits % 10 == 0)
+      {
+        digits /= 10;
+        --formatDigits;
+      }
+
+      const int length = FormatDigits(value < 0.f, digits, formatDigits, formatExponent, buffer);
+      if (!isTie || std::strtof(buffer, nullptr) == value)
+      {
+        return length;
+      }
+    }
+  }
+}
+
+///@brief Formats @a value, in the style of %g, with the fewest significant
+/// digits that parse back as the same double.
+///@return The length of the result.
+int FormatDouble(double value, char* buffer, size_t bufferSize)
+{
+  // If there is a representation shorter than 15 digits, %.15g finds it too (as
+  // trailing zeroes are dropped); 17 is always enough. Subnormals have fewer
+  // significant digits.
+  int length = 0;
+  for (int precision = std::fpclassify(value) == FP_SUBNORMAL ? 1 : 15; precision <= 17; ++precision)
+  {
+    length = snprintf(buffer, bufferSize, "%.*g", precision, value);
+    if (std::strtod(buffer, nullptr) == value)
+    {
+      break;
+    }
+  }
+  return length;
+}
+
+}
+
+JsonWriter::JsonWriter(std::ostream & stream, const char* indentation, Format format)
 : mStream(stream),
-  mIndentation(indentation ? indentation : "")
-{}
+  mIndentation(indentation && format == PRETTY ? indentation : ""),
+  mFormat(format)
+{
+  mBuffer.reserve(BUFFER_SIZE + BUFFER_SIZE / 2);
+  if (mFormat == BINARY)
+  {
+    PutCborHead(Cbor::TAG, Cbor::SELF_DESCRIBE_TAG);
+  }
+}
+
+JsonWriter::~JsonWriter()
+{
+  Flush();
+}
 
 void JsonWriter::WriteObject(const char* name, bool oneLiner)
 {
@@ -30,7 +288,7 @@ void JsonWriter::WriteObject(const char* name, bool oneLiner)
   }
 
   mScopes.push_back({ Scope::OBJECT, oneLiner, false });
-  mStream << '{';
+  Put(mFormat == BINARY ? Cbor::INDEFINITE_MAP : '{');
   NewLine(oneLiner);
 }
 
@@ -43,7 +301,7 @@ void JsonWriter::WriteArray(const char* name, bool oneLiner)
   }
 
   mScopes.push_back({ Scope::ARRAY, oneLiner, false });
-  mStream << '[';
+  Put(mFormat == BINARY ? Cbor::INDEFINITE_ARRAY : '[');
   NewLine(oneLiner);
 }
 
@@ -51,13 +309,26 @@ void JsonWriter::WriteValue(const char* name, const char* value)
 {
   WritePreamble(name);
   mScopes.back().needsComma = true;
-  if (value)
+  if (mFormat == BINARY)
+  {
+    if (value)
+    {
+      PutCborString(value);
+    }
+    else
+    {
+      Put(Cbor::NULL_VALUE);
+    }
+  }
+  else if (value)
   {
-    mStream << "\"" << value << "\"";
+    Put('"');
+    Put(value);
+    Put('"');
   }
   else
   {
-    mStream << "null";
+    Put("null");
   }
 }
 
@@ -65,28 +336,82 @@ void JsonWriter::WriteValue(const char* name, int value)
 {
   WritePreamble(name);
   mScopes.back().needsComma = true;
-  mStream << value;
+  if (mFormat == BINARY)
+  {
+    // Negative integers are encoded as -1 - n.
+    PutCborHead(value < 0 ? Cbor::NEGATIVE_INTEGER : Cbor::UNSIGNED_INTEGER,
+      value < 0 ? static_cast<uint64_t>(-1 - static_cast<int64_t>(value)) : value);
+    return;
+  }
+
+  char buffer[16];
+  Put(buffer, snprintf(buffer, sizeof(buffer), "%d", value));
 }
 
 void JsonWriter::WriteValue(const char* name, unsigned int value)
 {
   WritePreamble(name);
   mScopes.back().needsComma = true;
-  mStream << value;
+  if (mFormat == BINARY)
+  {
+    PutCborHead(Cbor::UNSIGNED_INTEGER, value);
+    return;
+  }
+
+  char buffer[16];
+  Put(buffer, snprintf(buffer, sizeof(buffer), "%u", value));
+}
+
+void JsonWriter::WriteValue(const char* name, float value)
+{
+  WritePreamble(name);
+  mScopes.back().needsComma = true;
+  if (mFormat == BINARY)
+  {
+    PutCborFloat(value);
+    return;
+  }
+
+  char buffer[32];
+  Put(buffer, FormatFloat(value, buffer, sizeof(buffer)));
 }
 
 void JsonWriter::WriteValue(const char* name, double value)
 {
   WritePreamble(name);
   mScopes.back().needsComma = true;
-  mStream << value;
+  if (mFormat == BINARY)
+  {
+    // Use the shorter encodings if they're exact.
+    const float single = static_cast<float>(value);
+    if (single == value || std::isnan(value))
+    {
+      PutCborFloat(single);
+      return;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    char buffer[9] = { Cbor::DOUBLE };
+    PutBigEndian(bits, 8, buffer + 1);
+    Put(buffer, 9);
+    return;
+  }
+
+  char buffer[32];
+  Put(buffer, FormatDouble(value, buffer, sizeof(buffer)));
 }
 
 void JsonWriter::WriteValue(const char* name, bool value)
 {
   WritePreamble(name);
   mScopes.back().needsComma = true;
-  mStream << std::boolalpha << value << std::noboolalpha;
+  if (mFormat == BINARY)
+  {
+    Put(value ? Cbor::TRUE : Cbor::FALSE);
+    return;
+  }
+  Put(value ? "true" : "false");
 }
 
 void JsonWriter::CloseScope()
@@ -94,19 +419,91 @@ void JsonWriter::CloseScope()
   const Scope scope = mScopes.back();
   mScopes.pop_back();
 
+  if (mFormat == BINARY)
+  {
+    Put(Cbor::BREAK);
+    return;
+  }
+
   if (scope.needsComma)
   {
     NewLine(scope.isOneLiner);
   }
   Indent(scope.isOneLiner);
-  mStream.put(scope.type);
+  Put(scope.type);
+}
+
+void JsonWriter::Flush()
+{
+  mStream.write(mBuffer.data(), mBuffer.size());
+  mBuffer.clear();
+}
+
+void JsonWriter::Put(const char* data, size_t size)
+{
+  mBuffer.append(data, size);
+  if (mBuffer.size() >= BUFFER_SIZE)
+  {
+    Flush();
+  }
+}
+
+void JsonWriter::Put(const char* str)
+{
+  Put(str, strlen(str));
+}
+
+void JsonWriter::PutCborHead(unsigned int majorType, uint64_t argument)
+{
+  char buffer[9];
+  const char type = static_cast<char>(majorType << 5);
+  if (argument < 24)
+  {
+    buffer[0] = type | static_cast<char>(argument);
+    Put(buffer, 1);
+  }
+  else
+  {
+    // Additional information 24 - 27 means 1, 2, 4, 8 bytes of argument.
+    unsigned int sizeLog2 = argument <= 0xff ? 0 : argument <= 0xffff ? 1 : argument <= 0xffffffff ? 2 : 3;
+    buffer[0] = type | static_cast<char>(24 + sizeLog2);
+    PutBigEndian(argument, 1 << sizeLog2, buffer + 1);
+    Put(buffer, 1 + (1 << sizeLog2));
+  }
+}
+
+void JsonWriter::PutCborFloat(float value)
+{
+  char buffer[5];
+  uint16_t half;
+  if (ToHalf(value, half))
+  {
+    buffer[0] = Cbor::HALF;
+    PutBigEndian(half, 2, buffer + 1);
+    Put(buffer, 3);
+  }
+  else
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    buffer[0] = Cbor::SINGLE;
+    PutBigEndian(bits, 4, buffer + 1);
+    Put(buffer, 5);
+  }
+}
+
+void JsonWriter::PutCborString(const char* str)
+{
+  const size_t length = strlen(str);
+  PutCborHead(Cbor::TEXT_STRING, length);
+  Put(str, length);
 }
 
 void JsonWriter::Comma()
 {
   if (!mScopes.empty() && mScopes.back().needsComma)
   {
-    mStream.put(',');
+    Put(',');
     NewLine(mScopes.back().isOneLiner);
   }
 }
@@ -115,10 +512,12 @@ void JsonWriter::Indent(bool oneLiner)
 {
   if (!oneLiner && !mIndentation.empty())
   {
-    for (auto& i : mScopes)
+    const size_t size = mScopes.size() * mIndentation.size();
+    while (mIndentations.size() < size)
     {
-      mStream << mIndentation;
+      mIndentations += mIndentation;
     }
+    Put(mIndentations.data(), size);
   }
 }
 
@@ -126,13 +525,27 @@ void JsonWriter::Name(const char* name)
 {
   assert((name != nullptr && !mScopes.empty() && mScopes.back().type == Scope::OBJECT) ||
     (name == nullptr && (mScopes.empty() || mScopes.back().type == Scope::ARRAY)));
-  if (name)
+  if (!name)
+  {
+    return;
+  }
+
+  if (mFormat == BINARY)
   {
-    mStream << "\"" << name << "\": ";
+    PutCborString(name);
+  }
+  else
+  {
+    Put('"');
+    Put(name);
+    Put(mFormat == COMPACT ? "\":" : "\": ");
   }
 }
 
 void JsonWriter::NewLine(bool oneLiner)
 {
-  mStream.put(oneLiner ? ' ' : '\n');
+  if (mFormat == PRETTY)
+  {
+    Put(oneLiner ? ' ' : '\n');
+  }
 }
@@ -18,6 +18,7 @@
 #include "LoadScene.h"
 #include "Mesh.h"
 #include "Util.h"
+#include "WorkerPool.h"
 
 #include "assimp/mesh.h"
 #include "assimp/scene.h"
@@ -29,6 +30,7 @@
 #include <algorithm>
 #include <cassert>
 #include <sstream>
+#include <memory>
 
 using namespace std;
 
@@ -37,20 +39,6 @@ namespace
 
 const unsigned int MAX_WEIGHTS_PER_VERTEX = std::extent<decltype(IVector4::data)>::value;
 
-bool NodeIsCamera(const aiScene *scene, std::string eName)
-{
-
-    for (unsigned int n = 0; n < scene->mNumCameras; n++)
-    {
-        const aiCamera *acam = scene->mCameras[n];
-        string camname;
-        camname.assign(acam->mName.data, acam->mName.length);
-        if (eName == camname)
-            return true;
-    }
-    return false;
-}
-
 void SetNodeMeshAndUpdateIds(const aiScene *scene, unsigned int id, Node3D& node, MeshIds& meshIds)
 {
     node.m_MeshId = id;
@@ -109,7 +97,16 @@ void ConsolidateSkeletons(std::vector<Node3D*> &skeletonRoots)
     }
 }
 
-void ConvertSceneBasedIndicesToSkeletonBased(Scene3D& scene_data)
+///@brief Maps the scene based indices of the joints of a skeleton to skeleton
+/// based ones. Joints occupy a contiguous range of scene indices when loaded
+/// from the aiNode hierarchy, so only that range is stored.
+struct SkeletonJointIds
+{
+    unsigned int firstNodeIndex = 0;
+    std::vector<unsigned int> jointIds; // indexed by the scene index of the node, less firstNodeIndex.
+};
+
+void ConvertSceneBasedIndicesToSkeletonBased(Scene3D& scene_data, WorkerPool* workers)
 {
     // The bone indices in our mesh data currently refer to nodes by their index in the scene;
     // We are converting "models", which are half-understood to be structurally immutable
@@ -121,285 +118,262 @@ void ConvertSceneBasedIndicesToSkeletonBased(Scene3D& scene_data)
     // based on their skeleton rather than the scene.
     // The index of the skeleton root is 0; the rest of the indices are assigned depth-first
     // (see Node3D::GetJoints()).
+    // First, work out the joint indices once per skeleton, which the meshes share.
+    std::unordered_map<const Node3D*, SkeletonJointIds> skeletons;
+    for (unsigned int i = 0; i < scene_data.GetNumSkeletonRoots(); ++i)
+    {
+        auto skeletonRoot = scene_data.GetSkeletonRoot(i);
+        auto joints = skeletonRoot->GetJoints();
+        auto iMinMax = std::minmax_element(joints.begin(), joints.end(), [](const Node3D* a, const Node3D* b) {
+            return a->m_Index < b->m_Index;
+        });
+
+        auto& skeleton = skeletons[skeletonRoot];
+        if (iMinMax.first != joints.end())
+        {
+            skeleton.firstNodeIndex = (*iMinMax.first)->m_Index;
+            skeleton.jointIds.resize((*iMinMax.second)->m_Index - skeleton.firstNodeIndex + 1, -1);
+        }
+
+        for (unsigned int j = 0; j < joints.size(); ++j)
+        {
+            skeleton.jointIds[joints[j]->m_Index - skeleton.firstNodeIndex] = j;
+        }
+    }
+
+    // Then update the skeleton of each mesh.
+    std::vector<std::pair<Mesh*, const SkeletonJointIds*>> skinnedMeshes;
     for (unsigned int i = 0; i < scene_data.GetNumMeshes(); ++i)
     {
         Mesh* m = scene_data.GetMesh(i);
         if (m->IsSkinned())
         {
-            // TODO: parallellize this.
-            // First update the skeleton of the mesh.
             auto skeletonRoot = m->m_Skeleton->m_Skeleton;
             assert(skeletonRoot == skeletonRoot->m_Skeleton);    // after consolidation, all bone nodes should point to their root.
-            if (m->m_Skeleton != skeletonRoot)
-            {
-                m->m_Skeleton = skeletonRoot;
-            }
+            m->m_Skeleton = skeletonRoot;
 
-            // Now convert the node indices from scene based to skeleton based.
-            auto joints = m->m_Skeleton->GetJoints();
-            std::vector<unsigned int> jointIds(scene_data.GetNumNodes(), -1); // TODO: this could really be per skeleton.
-            for (unsigned int i = 0; i < joints.size(); ++i)
-            {
-                jointIds[joints[i]->m_Index] = i;
-            }
-
-            for (auto &j : m->m_Joints0)
-            {
-                for (auto& ij : j.data)
-                {
-                    if (ij == -1)
-                    {
-                        break;
-                    }
-                    ij = static_cast<float>(jointIds[static_cast<uint32_t>(ij)]);
-                }
-            }
+            skinnedMeshes.push_back({ m, &skeletons[skeletonRoot] });
         }
     }
-}
 
-aiNode* FindLeafNamed(const string& eName, aiNode* node)
-{
-    if (node->mNumMeshes == 0 &&
-        node->mNumChildren == 0 &&
-        node->mName.length == eName.size() &&
-        strncmp(node->mName.data, eName.c_str(), node->mName.length) == 0)
-    {
-        return node;
-    }
-    else
-    {
-        aiNode* result = nullptr;
-        auto iEnd = node->mChildren + node->mNumChildren;
-        for (auto i = node->mChildren; i != iEnd; ++i)
+    // Now convert the node indices from scene based to skeleton based.
+    WorkerPool::Execute(workers, skinnedMeshes.size(), [&skinnedMeshes](unsigned int i) {
+        Mesh* m = skinnedMeshes[i].first;
+        const SkeletonJointIds& skeleton = *skinnedMeshes[i].second;
+        for (auto &j : m->m_Joints0)
         {
-            if (auto n = FindLeafNamed(eName, *i))
+            for (auto& ij : j.data)
             {
-                result = n;
-                break;
+                if (ij == -1)
+                {
+                    break;
+                }
+                // Nodes outside the skeleton map to -1, as they always have.
+                const uint32_t iJoint = static_cast<uint32_t>(ij) - skeleton.firstNodeIndex;
+                ij = static_cast<float>(iJoint < skeleton.jointIds.size() ? skeleton.jointIds[iJoint] : -1u);
             }
         }
-        return result;
-    }
+    });
 }
 
-void SetBlendShapeHeader(Mesh* pmesh, unsigned int totalTextureSize)
+template <typename T>
+void ReleaseArray(T*& data)
 {
-  // Calculates the width and height needed to store the blend shapes into a texture.
-  unsigned int pow2 = 0u;
-  ++totalTextureSize;
-  while (totalTextureSize > 0u)
-  {
-    ++pow2;
-    totalTextureSize = (totalTextureSize >> 1u);
-  }
-
-  const unsigned int powWidth = pow2 / 2u;
-  const unsigned int powHeight = pow2 - powWidth;
-
-  pmesh->m_BlendShapeHeader.width = 1u << powWidth;
-  pmesh->m_BlendShapeHeader.height = 1u << powHeight;
+    delete[] data;
+    data = nullptr;
 }
 
-
-} // namespace
-
-void GetSceneNodes(Scene3D &scene_data, MeshIds& meshIds, Node3D *parent, const aiScene *scene, const aiNode *aNode)
+///@brief Releases the data of @a mesh that ConvertMesh() copies, leaving the
+/// rest - i.e. the offset matrices of the bones, which are used when merging
+/// the results - intact.
+void ReleaseMeshData(aiMesh* mesh)
 {
-    if(0 == aNode->mNumMeshes && 0 == aNode->mNumChildren)
+    ReleaseArray(mesh->mVertices);
+    ReleaseArray(mesh->mNormals);
+    ReleaseArray(mesh->mTangents);
+    ReleaseArray(mesh->mBitangents);
+    for (auto& colors : mesh->mColors)
     {
-        string camname(aNode->mName.data, aNode->mName.length);
-        if( NodeIsCamera( scene, camname ) )
-        {
-            return;
-        }
+        ReleaseArray(colors);
     }
-
-    Node3D *pnode = new Node3D(parent);
-    pnode->m_Name.assign(aNode->mName.data,aNode->mName.length);
-    Matrix::SetMatrix(aNode->mTransformation, pnode->m_Matrix.data);
-    scene_data.AddNode(pnode);
-
-    if (aNode->mNumMeshes > 0)
+    for (auto& uvs : mesh->mTextureCoords)
     {
-        auto meshId = aNode->mMeshes[0];
-        SetNodeMeshAndUpdateIds(scene, meshId, *pnode, meshIds);
-
-        // Create an anonymous node each for the rest of the meshes, with the same transform.
-        for (unsigned int i = 1; i < aNode->mNumMeshes; ++i)
-        {
-            Node3D* node = new Node3D(parent);
-            node->m_Name.assign(aNode->mName.data, aNode->mName.length);
-            node->m_Name += "_" + std::to_string(i);
-
-            Matrix::SetMatrix(aNode->mTransformation, node->m_Matrix.data);
-
-            SetNodeMeshAndUpdateIds(scene, aNode->mMeshes[i], *node, meshIds);
+        ReleaseArray(uvs);
+    }
+    ReleaseArray(mesh->mFaces);
+    mesh->mNumFaces = 0;
 
-            scene_data.AddNode(node);
-        }
+    for (unsigned int i = 0; i < mesh->mNumBones; ++i)
+    {
+        ReleaseArray(mesh->mBones[i]->mWeights);
+        mesh->mBones[i]->mNumWeights = 0;
     }
 
-    for(unsigned int c = 0; c < aNode->mNumChildren; c++ )
+    for (unsigned int i = 0; i < mesh->mNumAnimMeshes; ++i)
     {
-        GetSceneNodes(scene_data, meshIds, pnode, scene, aNode->mChildren[c]);
+        aiAnimMesh* animMesh = mesh->mAnimMeshes[i];
+        ReleaseArray(animMesh->mVertices);
+        ReleaseArray(animMesh->mNormals);
+        ReleaseArray(animMesh->mTangents);
+        ReleaseArray(animMesh->mBitangents);
     }
 }
 
-void PackSceneNodeMeshIds(Scene3D& scene_data, const MeshIds& meshIds)
+///@brief The result of converting a single aiMesh. This doesn't modify the
+/// Scene3D, so that meshes may be converted concurrently; the skeletons (and
+/// inverse bind pose matrices) that they reference are registered when the
+/// results are merged, in the order of the meshes.
+struct MeshConversion
 {
-    for (unsigned int i = 0; i < scene_data.GetNumNodes(); ++i)
+    Mesh mesh;
+    std::vector<std::pair<Node3D*, const aiBone*>> bones;   // nodes of the bones with weights, in the order of aiMesh::mBones.
+    std::ostringstream log;
+    bool success = true;    // false if a bone referenced an invalid joint; the bones before it are still registered.
+};
+
+///@brief Sets @a target to a view of - or if @a copy, a copy of - the
+/// @a numVertices vectors at @a source.
+void SetVertices(const aiVector3D* source, unsigned int numVertices, bool copy, VertexArray<Vector3>& target)
+{
+    static_assert(sizeof(aiVector3D) == sizeof(Vector3), "aiVector3D and Vector3 must be layout compatible.");
+    auto vertices = reinterpret_cast<const Vector3*>(source);
+    if (copy)
     {
-        auto node = scene_data.GetNode(i);
-        if (node->HasMesh())
-        {
-            auto iFind = std::lower_bound(meshIds.begin(), meshIds.end(), node->m_MeshId);
-            assert(iFind != meshIds.end());
-            node->m_MeshId = std::distance(meshIds.begin(), iFind);
-        }
+        target.assign(vertices, vertices + numVertices);
+    }
+    else
+    {
+        target.SetView(vertices, numVertices);
     }
 }
 
-void GetSceneMeshes(Scene3D& scene_data, const MeshIds& meshIds, const aiScene* scene)
+void ConvertMesh(const Scene3D& scene_data, const aiMesh* mesh, bool copyVertices, MeshConversion& result)
 {
-    std::vector<Node3D*> skeletonRoots;
+    auto& log = result.log;
 
-    for (auto& i : meshIds)
-    {
-        struct aiMesh *mesh = scene->mMeshes[i];
+    Mesh* pmesh = &result.mesh;
 
-        Mesh* pmesh = new Mesh();
-        pmesh->m_Indices.reserve(mesh->mNumFaces * 3);
-        for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+    // aiProcess_Triangulate leaves lines and points as they are; only triangles are kept.
+    pmesh->m_Indices.resize(mesh->mNumFaces * 3);
+    uint32_t* indices = pmesh->m_Indices.data();
+    for (const aiFace* face = mesh->mFaces, *end = face + mesh->mNumFaces; face != end; ++face)
+    {
+        if (face->mNumIndices == 3)
         {
-            struct aiFace *face = &mesh->mFaces[f];
-
-            assert(face->mNumIndices == 3);    // aiProcess_Triangulate
-            for (unsigned int i = 0; i < face->mNumIndices; i++)
-            {
-                unsigned short index = face->mIndices[i];
-                pmesh->m_Indices.push_back(index);
-            }
+            indices[0] = face->mIndices[0];
+            indices[1] = face->mIndices[1];
+            indices[2] = face->mIndices[2];
+            indices += 3;
         }
+    }
 
-        if (mesh->HasPositions())
-        {
-            pmesh->m_Positions.assign(reinterpret_cast<Vector3*>(mesh->mVertices), reinterpret_cast<Vector3*>(mesh->mVertices + mesh->mNumVertices));
-        }
-        if (mesh->HasNormals())
-        {
-            pmesh->m_Normals.assign(reinterpret_cast<Vector3*>(mesh->mNormals), reinterpret_cast<Vector3*>(mesh->mNormals + mesh->mNumVertices));
-        }
-        if (!mesh->HasTextureCoords(0))
-        {
-            cout << "Generating default texture coordinates." << endl;
-            Vector2 uv;
-            pmesh->m_Textures.resize(mesh->mNumVertices, uv);
-        }
-        else
+    const size_t numIndices = indices - pmesh->m_Indices.data();
+    if (numIndices < pmesh->m_Indices.size())
+    {
+        log << "WARNING: Skipped " << mesh->mNumFaces - numIndices / 3 << " face(s) of mesh '" <<
+            mesh->mName.C_Str() << "' which aren't triangles." << endl;
+        pmesh->m_Indices.resize(numIndices);
+    }
+
+    if (mesh->HasPositions())
+    {
+        SetVertices(mesh->mVertices, mesh->mNumVertices, copyVertices, pmesh->m_Positions);
+    }
+    if (mesh->HasNormals())
+    {
+        SetVertices(mesh->mNormals, mesh->mNumVertices, copyVertices, pmesh->m_Normals);
+    }
+    if (!mesh->HasTextureCoords(0))
+    {
+        log << "Generating default texture coordinates." << endl;
+        Vector2 uv;
+        pmesh->m_Textures.resize(mesh->mNumVertices, uv);
+    }
+    else
+    {
+        if (mesh->mNumUVComponents[0] == 2)
         {
-            if (mesh->mNumUVComponents[0] == 2)
+            pmesh->m_Textures.resize(mesh->mNumVertices);
+            Vector2* uv = pmesh->m_Textures.data();
+            for (const aiVector3D* co = mesh->mTextureCoords[0], *end = co + mesh->mNumVertices; co != end; ++co)
             {
-                pmesh->m_Textures.reserve(mesh->mNumVertices);
-                for (unsigned int co = 0; co < mesh->mNumVertices; co++)
-                {
-                    Vector2 uv;
-                    uv.x = mesh->mTextureCoords[0][co].x;
-                    uv.y = mesh->mTextureCoords[0][co].y;
-                    pmesh->m_Textures.push_back(uv);
-                }
-            }
-            else
-            {
-                cout << "3D textures coords not supported." << endl;
+                uv->x = co->x;
+                uv->y = co->y;
+                ++uv;
             }
         }
-
-        if (!mesh->mTangents)
-        {
-            cout << "Generating default tangents." << endl;
-            Vector3 AXIS_Z;
-            AXIS_Z.z = 1.f;
-            pmesh->m_Tangents.resize(mesh->mNumVertices, AXIS_Z);
-        }
         else
         {
-            pmesh->m_Tangents.assign(reinterpret_cast<Vector3*>(mesh->mTangents), reinterpret_cast<Vector3*>(mesh->mTangents + mesh->mNumVertices));
+            log << "3D textures coords not supported." << endl;
         }
+    }
 
-        if (0 != mesh->mNumBones)   // Get skinning data
-        {
-            pmesh->m_Joints0.resize(pmesh->m_Positions.size(), Vector4 { .0, .0, .0, .0 });
-            pmesh->m_Weights0.resize(pmesh->m_Positions.size(), Vector4 { .0, .0, .0, .0 });
+    if (!mesh->mTangents)
+    {
+        log << "Generating default tangents." << endl;
+        Vector3 AXIS_Z;
+        AXIS_Z.z = 1.f;
+        pmesh->m_Tangents.resize(mesh->mNumVertices, AXIS_Z);
+    }
+    else
+    {
+        SetVertices(mesh->mTangents, mesh->mNumVertices, copyVertices, pmesh->m_Tangents);
+    }
 
-            std::vector<int> nextBone;
-            nextBone.resize(pmesh->m_Positions.size(), 0);
+    if (0 != mesh->mNumBones)   // Get skinning data
+    {
+        pmesh->m_Joints0.resize(pmesh->m_Positions.size(), Vector4 { .0, .0, .0, .0 });
+        pmesh->m_Weights0.resize(pmesh->m_Positions.size(), Vector4 { .0, .0, .0, .0 });
 
-            auto iBone = mesh->mBones;
-            for (auto endBones = iBone + mesh->mNumBones; iBone != endBones; ++iBone)
+        std::vector<int> nextBone;
+        nextBone.resize(pmesh->m_Positions.size(), 0);
+
+        auto iBone = mesh->mBones;
+        for (auto endBones = iBone + mesh->mNumBones; iBone != endBones; ++iBone)
+        {
+            auto bone = *iBone;
+            if (bone->mNumWeights == 0)
             {
-                auto bone = *iBone;
-                if (bone->mNumWeights == 0)
-                {
-                    continue;
-                }
+                continue;
+            }
 
-                auto boneNode = scene_data.FindNodeNamed(bone->mName.C_Str());
-                if (!boneNode)
-                {
-                    cout << "ERROR: Bone '" << bone->mName.C_Str() << "' of mesh '" << mesh->mName.C_Str() <<
-                        "' references invalid joint '" << bone->mName.C_Str() << "'." << endl;
-                    return;
-                }
+            auto boneNode = scene_data.FindNodeNamed(bone->mName.C_Str());
+            if (!boneNode)
+            {
+                log << "ERROR: Bone '" << bone->mName.C_Str() << "' of mesh '" << mesh->mName.C_Str() <<
+                    "' references invalid joint '" << bone->mName.C_Str() << "'." << endl;
+                result.success = false;
+                return;
+            }
 
-                if (!boneNode->m_InverseBindPoseMatrix)
-                {
-                    boneNode->m_InverseBindPoseMatrix.reset(new Matrix(bone->mOffsetMatrix));
-                }
+            result.bones.push_back({ boneNode, bone });
 
-                // register the new skeleton.
-                auto iInsert = std::lower_bound(skeletonRoots.begin(), skeletonRoots.end(), boneNode);
-                if (iInsert == skeletonRoots.end() || *iInsert != boneNode)
+            // save weights
+            auto iWeight = bone->mWeights;
+            for (auto endWeights = iWeight + bone->mNumWeights; iWeight != endWeights; ++iWeight)
+            {
+                if (iWeight->mWeight == 0.f)
                 {
-                    skeletonRoots.insert(iInsert, boneNode);
-                    boneNode->m_Skeleton = boneNode;
+                    continue;
                 }
-
-                if (!pmesh->m_Skeleton)
+                int iNextBone = nextBone[iWeight->mVertexId];
+                if (iNextBone < MAX_WEIGHTS_PER_VERTEX)
                 {
-                    // Assign the first bone as the skeleton of the mesh. At this point we don't know the
-                    // relation of the bone nodes, so this is potentially not the root of the skeleton.
-                    // However, after we have consolidated the skeletons, we will know the root - we update
-                    // the skeleton of the mesh to it at that point.
-                    pmesh->m_Skeleton = boneNode->m_Skeleton;
+                    // NOTE: at this point we're writing the scene based joint (node) ids;
+                    // we will convert it to a skeleton basad index once we've established
+                    // the skeletons.
+                    pmesh->m_Joints0[iWeight->mVertexId].data[iNextBone] = static_cast<float>(boneNode->m_Index);
+                    pmesh->m_Weights0[iWeight->mVertexId].data[iNextBone] = iWeight->mWeight;
+                    ++nextBone[iWeight->mVertexId];
                 }
-
-                // save weights
-                auto iWeight = bone->mWeights;
-                for (auto endWeights = iWeight + bone->mNumWeights; iWeight != endWeights; ++iWeight)
+                else
                 {
-                    if (iWeight->mWeight == 0.f)
-                    {
-                        continue;
-                    }
-                    int iNextBone = nextBone[iWeight->mVertexId];
-                    if (iNextBone < MAX_WEIGHTS_PER_VERTEX)
-                    {
-                        // NOTE: at this point we're writing the scene based joint (node) ids;
-                        // we will convert it to a skeleton basad index once we've established
-                        // the skeletons.
-                        pmesh->m_Joints0[iWeight->mVertexId].data[iNextBone] = static_cast<float>(boneNode->m_Index);
-                        pmesh->m_Weights0[iWeight->mVertexId].data[iNextBone] = iWeight->mWeight;
-                        ++nextBone[iWeight->mVertexId];
-                    }
-                    else
-                    {
-                        cout << "WARNING: Vertex " << iWeight->mVertexId << " of mesh '" << mesh->mName.C_Str() <<
-                            "' exceeds the number of supported weights." << endl;
-                    }
+                    log << "WARNING: Vertex " << iWeight->mVertexId << " of mesh '" << mesh->mName.C_Str() <<
+                        "' exceeds the number of supported weights." << endl;
                 }
             }
         }
+    }
 
     // Read the blend shapes
     if ((0u != mesh->mNumAnimMeshes) && (nullptr != mesh->mAnimMeshes))
@@ -407,7 +381,6 @@ void GetSceneMeshes(Scene3D& scene_data, const MeshIds& meshIds, const aiScene*
       pmesh->m_MorphMethod = mesh->mMethod;
 
       pmesh->m_BlendShapes.resize(mesh->mNumAnimMeshes);
-      unsigned int totalTextureSize = 0u;
       auto index = 0u;
       for (auto meshIt = mesh->mAnimMeshes; index < mesh->mNumAnimMeshes; ++meshIt, ++index)
       {
@@ -420,65 +393,193 @@ void GetSceneMeshes(Scene3D& scene_data, const MeshIds& meshIds, const aiScene*
         if (animMesh->HasPositions())
         {
           blendShape.m_Positions.assign(reinterpret_cast<Vector3*>(animMesh->mVertices), reinterpret_cast<Vector3*>(animMesh->mVertices + animMesh->mNumVertices));
-          totalTextureSize += animMesh->mNumVertices;
         }
         if (animMesh->HasNormals())
         {
           blendShape.m_Normals.assign(reinterpret_cast<Vector3*>(animMesh->mNormals), reinterpret_cast<Vector3*>(animMesh->mNormals + animMesh->mNumVertices));
-          totalTextureSize += animMesh->mNumVertices;
         }
 
         if (animMesh->HasTangentsAndBitangents())
         {
           blendShape.m_Tangents.assign(reinterpret_cast<Vector3*>(animMesh->mTangents), reinterpret_cast<Vector3*>(animMesh->mTangents + animMesh->mNumVertices));
-          totalTextureSize += animMesh->mNumVertices;
         }
 
         blendShape.m_Weight = 0.f;
       }
 
-      SetBlendShapeHeader(pmesh, totalTextureSize);
+      pmesh->UpdateBlendShapeHeader();
     }
+}
 
-        scene_data.AddMesh(pmesh);
+} // namespace
+
+SceneNodeIndex::SceneNodeIndex(const aiScene* scene)
+{
+    for (unsigned int n = 0; n < scene->mNumCameras; n++)
+    {
+        const aiCamera *acam = scene->mCameras[n];
+        m_CameraNames.emplace(acam->mName.data, acam->mName.length);
     }
 
-    ConsolidateSkeletons(skeletonRoots);
+    if (scene->mRootNode)
+    {
+        AddNode(scene->mRootNode, aiMatrix4x4());
+    }
+}
 
-    // Add skeletons to scene.
-    for (auto i : skeletonRoots)
+const aiNode* SceneNodeIndex::FindLeafNamed(const std::string& name) const
+{
+    auto iFind = m_Leaves.find(name);
+    return iFind != m_Leaves.end() ? iFind->second : nullptr;
+}
+
+bool SceneNodeIndex::IsCameraNode(const aiNode* node) const
+{
+    return node->mNumMeshes == 0 && node->mNumChildren == 0 &&
+        m_CameraNames.count(std::string(node->mName.data, node->mName.length)) > 0;
+}
+
+const aiMatrix4x4& SceneNodeIndex::GetGlobalTransform(const aiNode* node) const
+{
+    return m_GlobalTransforms.find(node)->second;
+}
+
+void SceneNodeIndex::AddNode(const aiNode* node, const aiMatrix4x4& parentTransform)
+{
+    const aiMatrix4x4& transform = m_GlobalTransforms.emplace(node, parentTransform * node->mTransformation).first->second;
+
+    if (node->mNumMeshes == 0 && node->mNumChildren == 0)
     {
-        scene_data.AddSkeletonRoot(i);
+        // Keep the first one in depth first order.
+        m_Leaves.emplace(std::string(node->mName.data, node->mName.length), node);
+    }
+
+    auto iEnd = node->mChildren + node->mNumChildren;
+    for (auto i = node->mChildren; i != iEnd; ++i)
+    {
+        AddNode(*i, transform);
+    }
+}
+
+void GetSceneNodes(Scene3D &scene_data, MeshIds& meshIds, Node3D *parent, const aiScene *scene, const aiNode *aNode,
+    const SceneNodeIndex& index)
+{
+    if( index.IsCameraNode( aNode ) )
+    {
+        return;
+    }
+
+    Node3D *pnode = scene_data.CreateNode(parent);
+    pnode->m_Name.assign(aNode->mName.data,aNode->mName.length);
+    Matrix::SetMatrix(aNode->mTransformation, pnode->m_Matrix.data);
+    scene_data.AddNode(pnode);
+
+    if (aNode->mNumMeshes > 0)
+    {
+        auto meshId = aNode->mMeshes[0];
+        SetNodeMeshAndUpdateIds(scene, meshId, *pnode, meshIds);
+
+        // Create an anonymous node each for the rest of the meshes, with the same transform.
+        for (unsigned int i = 1; i < aNode->mNumMeshes; ++i)
+        {
+            Node3D* node = scene_data.CreateNode(parent);
+            node->m_Name.assign(aNode->mName.data, aNode->mName.length);
+            node->m_Name += "_" + std::to_string(i);
+
+            Matrix::SetMatrix(aNode->mTransformation, node->m_Matrix.data);
+
+            SetNodeMeshAndUpdateIds(scene, aNode->mMeshes[i], *node, meshIds);
+
+            scene_data.AddNode(node);
+        }
     }
 
-    ConvertSceneBasedIndicesToSkeletonBased(scene_data);
+    for(unsigned int c = 0; c < aNode->mNumChildren; c++ )
+    {
+        GetSceneNodes(scene_data, meshIds, pnode, scene, aNode->mChildren[c], index);
+    }
 }
 
-aiNode *GetCameraNode( const aiScene *scene, aiNode *aNode )
+void PackSceneNodeMeshIds(Scene3D& scene_data, const MeshIds& meshIds)
 {
-    if(!aNode->mNumMeshes)
+    for (unsigned int i = 0; i < scene_data.GetNumNodes(); ++i)
     {
-        if(!aNode->mNumChildren)
+        auto node = scene_data.GetNode(i);
+        if (node->HasMesh())
         {
-            string camname;
-            camname.assign(aNode->mName.data,aNode->mName.length);
-            if( NodeIsCamera( scene, camname ) )
+            auto iFind = std::lower_bound(meshIds.begin(), meshIds.end(), node->m_MeshId);
+            assert(iFind != meshIds.end());
+            node->m_MeshId = std::distance(meshIds.begin(), iFind);
+        }
+    }
+}
+
+void GetSceneMeshes(Scene3D& scene_data, const MeshIds& meshIds, const aiScene* scene, WorkerPool* workers,
+    bool releaseSource)
+{
+    std::vector<MeshConversion> conversions(meshIds.size());
+    WorkerPool::Execute(workers, meshIds.size(), [&](unsigned int i) {
+        ConvertMesh(scene_data, scene->mMeshes[meshIds[i]], releaseSource, conversions[i]);
+        if (releaseSource)
+        {
+            ReleaseMeshData(scene->mMeshes[meshIds[i]]);
+        }
+    });
+
+    // Merge the results in order, so that the output doesn't depend on the
+    // number of threads.
+    std::vector<Node3D*> skeletonRoots;
+    for (auto& c : conversions)
+    {
+        cout << c.log.str();
+
+        Mesh* pmesh = &c.mesh;
+        for (auto& b : c.bones)
+        {
+            auto boneNode = b.first;
+            if (!boneNode->m_InverseBindPoseMatrix)
+            {
+                boneNode->m_InverseBindPoseMatrix.reset(new Matrix(b.second->mOffsetMatrix));
+            }
+
+            // register the new skeleton.
+            auto iInsert = std::lower_bound(skeletonRoots.begin(), skeletonRoots.end(), boneNode);
+            if (iInsert == skeletonRoots.end() || *iInsert != boneNode)
+            {
+                skeletonRoots.insert(iInsert, boneNode);
+                boneNode->m_Skeleton = boneNode;
+            }
+
+            if (!pmesh->m_Skeleton)
             {
-                return aNode;
+                // Assign the first bone as the skeleton of the mesh. At this point we don't know the
+                // relation of the bone nodes, so this is potentially not the root of the skeleton.
+                // However, after we have consolidated the skeletons, we will know the root - we update
+                // the skeleton of the mesh to it at that point.
+                pmesh->m_Skeleton = boneNode->m_Skeleton;
             }
         }
+
+        if (!c.success)
+        {
+            return;
+        }
+
+        scene_data.AddMesh(std::move(c.mesh));
     }
 
-    for(unsigned int c = 0; c < aNode->mNumChildren; c++ )
+    ConsolidateSkeletons(skeletonRoots);
+
+    // Add skeletons to scene.
+    for (auto i : skeletonRoots)
     {
-        aiNode *returnNode = GetCameraNode( scene, aNode->mChildren[c]);
-        if(returnNode)
-            return returnNode;
+        scene_data.AddSkeletonRoot(i);
     }
-    return nullptr;
+
+    ConvertSceneBasedIndicesToSkeletonBased(scene_data, workers);
 }
 
-void GetSceneCameras( Scene3D &scene_data, const aiScene *scene )
+void GetSceneCameras( Scene3D &scene_data, const aiScene *scene, const SceneNodeIndex& index )
 {
     for( unsigned int n = 0; n < scene->mNumCameras; n++ )
     {
@@ -499,22 +600,17 @@ void GetSceneCameras( Scene3D &scene_data, const aiScene *scene )
         vPosition.x = acam->mPosition.x;
         vPosition.y = acam->mPosition.y;
         vPosition.z = acam->mPosition.z;
-        aiNode *pnode = GetCameraNode( scene, scene->mRootNode );
+        const aiNode *pnode = index.FindLeafNamed( string(acam->mName.data, acam->mName.length) );
         if( pnode )
         {
-            aiMatrix4x4 globalMat(pnode->mTransformation );
-            while ( pnode = pnode->mParent )
-            {
-                globalMat = pnode->mTransformation * globalMat;
-            }
-            cam.SetMatrix( globalMat );
+            cam.SetMatrix( index.GetGlobalTransform( pnode ) );
             cam.MultLookAtMatrix( vlookat, vUp , vPosition );
             scene_data.AddCamera( cam );
         }
     }
 }
 
-void GetSceneLights( Scene3D& scene_data, const aiScene* scene)
+void GetSceneLights( Scene3D& scene_data, const aiScene* scene, const SceneNodeIndex& index )
 {
     for( unsigned int n = 0; n < scene->mNumLights; ++n)
     {
@@ -522,7 +618,7 @@ void GetSceneLights( Scene3D& scene_data, const aiScene* scene)
         string name(aLight->mName.data, aLight->mName.length);
 
         Light light;
-        aiNode* node = FindLeafNamed( name, scene->mRootNode );
+        const aiNode* node = index.FindLeafNamed( name );
         if (node)
         {
             light.SetMatrix(node->mTransformation);
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "Mesh.h"
+
+void Mesh::UpdateBlendShapeHeader()
+{
+  unsigned int totalTextureSize = 0u;
+  for (auto& blendShape : m_BlendShapes)
+  {
+    totalTextureSize += blendShape.m_Positions.size() + blendShape.m_Normals.size() + blendShape.m_Tangents.size();
+  }
+
+  unsigned int pow2 = 0u;
+  ++totalTextureSize;
+  while (totalTextureSize > 0u)
+  {
+    ++pow2;
+    totalTextureSize = (totalTextureSize >> 1u);
+  }
+
+  const unsigned int powWidth = pow2 / 2u;
+  const unsigned int powHeight = pow2 - powWidth;
+
+  m_BlendShapeHeader.width = 1u << powWidth;
+  m_BlendShapeHeader.height = 1u << powHeight;
+}
@@ -0,0 +1,960 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "MeshOptimizer.h"
+#include "Hash.h"
+#include "Scene3D.h"
+#include "Util.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+
+const uint32_t INVALID_INDEX = static_cast<uint32_t>(-1);
+
+///@brief Appends the elements of @a source at the given @a vertices to @a target,
+/// if @a source has data for all @a numVertices vertices; otherwise leaves it empty.
+template <typename Array>
+void GatherVertices(const Array& source, size_t numVertices, const std::vector<uint32_t>& vertices, Array& target)
+{
+  if (source.size() == numVertices)
+  {
+    target.reserve(vertices.size());
+    for (auto v : vertices)
+    {
+      target.push_back(source[v]);
+    }
+  }
+}
+
+///@brief Creates a mesh with the data of the given @a vertices of @a mesh, but no indices.
+Mesh MakePart(const Mesh& mesh, const std::vector<uint32_t>& vertices)
+{
+  const size_t numVertices = mesh.m_Positions.size();
+
+  Mesh part;
+  GatherVertices(mesh.m_Positions, numVertices, vertices, part.m_Positions);
+  GatherVertices(mesh.m_Normals, numVertices, vertices, part.m_Normals);
+  GatherVertices(mesh.m_Tangents, numVertices, vertices, part.m_Tangents);
+  GatherVertices(mesh.m_Textures, numVertices, vertices, part.m_Textures);
+  GatherVertices(mesh.m_Joints0, numVertices, vertices, part.m_Joints0);
+  GatherVertices(mesh.m_Weights0, numVertices, vertices, part.m_Weights0);
+  part.m_Skeleton = mesh.m_Skeleton;
+
+  part.m_MorphMethod = mesh.m_MorphMethod;
+  part.m_BlendShapes.resize(mesh.m_BlendShapes.size());
+  auto iTarget = part.m_BlendShapes.begin();
+  for (auto& blendShape : mesh.m_BlendShapes)
+  {
+    iTarget->m_Name = blendShape.m_Name;
+    iTarget->m_Weight = blendShape.m_Weight;
+    GatherVertices(blendShape.m_Positions, numVertices, vertices, iTarget->m_Positions);
+    GatherVertices(blendShape.m_Normals, numVertices, vertices, iTarget->m_Normals);
+    GatherVertices(blendShape.m_Tangents, numVertices, vertices, iTarget->m_Tangents);
+    ++iTarget;
+  }
+
+  if (!part.m_BlendShapes.empty())
+  {
+    part.UpdateBlendShapeHeader();
+  }
+  return part;
+}
+
+
+// The parameters of the vertex scores of OptimizeVertexCache(), as suggested by Forsyth.
+const unsigned int SCORING_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+const unsigned int MAX_PRECALCULATED_VALENCE = 32;
+
+///@brief The scores of vertices, by their position in the (LRU) cache and
+/// by the number of triangles that use them, which are yet to be drawn.
+class VertexScores
+{
+public:
+  VertexScores()
+  {
+    for (unsigned int i = 0; i < SCORING_CACHE_SIZE; ++i)
+    {
+      if (i < 3)
+      {
+        // The vertices of the last triangle are in the cache whichever way
+        // we go; don't favour using them again too much.
+        m_CachePositionScores[i] = LAST_TRIANGLE_SCORE;
+      }
+      else
+      {
+        const float scale = 1.f / (SCORING_CACHE_SIZE - 3);
+        m_CachePositionScores[i] = std::pow(1.f - (i - 3) * scale, CACHE_DECAY_POWER);
+      }
+    }
+
+    for (unsigned int i = 0; i < MAX_PRECALCULATED_VALENCE; ++i)
+    {
+      m_ValenceScores[i] = CalculateValenceScore(i);
+    }
+  }
+
+  ///@param cachePosition The position of the vertex in the cache, INVALID_INDEX
+  /// if it isn't in the cache.
+  ///@param numTriangles The number of triangles left to draw with the vertex.
+  float Get(uint32_t cachePosition, uint32_t numTriangles) const
+  {
+    if (numTriangles == 0)
+    {
+      return -1.f;
+    }
+
+    float score = cachePosition < SCORING_CACHE_SIZE ? m_CachePositionScores[cachePosition] : 0.f;
+    score += numTriangles < MAX_PRECALCULATED_VALENCE ? m_ValenceScores[numTriangles] :
+      CalculateValenceScore(numTriangles);
+    return score;
+  }
+
+private:
+  static float CalculateValenceScore(uint32_t numTriangles)
+  {
+    return numTriangles > 0 ? VALENCE_BOOST_SCALE * std::pow(static_cast<float>(numTriangles), -VALENCE_BOOST_POWER) : 0.f;
+  }
+
+  float m_CachePositionScores[SCORING_CACHE_SIZE];
+  float m_ValenceScores[MAX_PRECALCULATED_VALENCE];
+};
+
+///@brief The triangles that each vertex is used by, in a single allocation.
+struct VertexTriangles
+{
+  std::vector<uint32_t> offsets;  // the first of the triangles of each vertex.
+  std::vector<uint32_t> counts;   // the number of triangles of each vertex.
+  std::vector<uint32_t> triangles;
+
+  VertexTriangles(const std::vector<uint32_t>& indices, unsigned int numVertices)
+  : offsets(numVertices),
+    counts(numVertices),
+    triangles(indices.size())
+  {
+    for (auto i : indices)
+    {
+      ++counts[i];
+    }
+
+    uint32_t offset = 0;
+    for (unsigned int v = 0; v < numVertices; ++v)
+    {
+      offsets[v] = offset;
+      offset += counts[v];
+      counts[v] = 0;
+    }
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      const uint32_t v = indices[i];
+      triangles[offsets[v] + counts[v]] = i / 3;
+      ++counts[v];
+    }
+  }
+
+  ///@brief Removes @a triangle from the ones that vertex @a v is used by,
+  /// if it's still there, which it might not be for degenerate triangles.
+  void Remove(uint32_t v, uint32_t triangle)
+  {
+    auto begin = triangles.begin() + offsets[v];
+    auto end = begin + counts[v];
+    auto iFind = std::find(begin, end, triangle);
+    if (iFind != end)
+    {
+      *iFind = *(end - 1);
+      --counts[v];
+    }
+  }
+};
+
+
+///@brief A simulation of the FIFO post transform cache of a GPU. A vertex is
+/// in the cache if no more than its size vertices have been transformed since
+/// it was last.
+class VertexCache
+{
+public:
+  VertexCache(unsigned int numVertices, unsigned int size)
+  : m_Timestamps(numVertices, 0),
+    m_Size(size),
+    m_Time(size + 1)
+  {}
+
+  ///@return Whether vertex @a v had to be transformed, i.e. it wasn't in the cache.
+  bool Use(uint32_t v)
+  {
+    if (m_Time - m_Timestamps[v] > m_Size)
+    {
+      m_Timestamps[v] = m_Time++;
+      return true;
+    }
+    return false;
+  }
+
+  ///@brief Evicts all vertices.
+  void Flush()
+  {
+    m_Time += m_Size + 1;
+  }
+
+private:
+  std::vector<uint32_t> m_Timestamps;
+  unsigned int m_Size;
+  uint32_t m_Time;
+};
+
+Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+  Vector3 result;
+  result.x = a.y * b.z - a.z * b.y;
+  result.y = a.z * b.x - a.x * b.z;
+  result.z = a.x * b.y - a.y * b.x;
+  return result;
+}
+
+float Dot(const Vector3& a, const Vector3& b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+///@brief Splits the triangles of @a indices, into a buffer of @a numVertices,
+/// into clusters for OptimizeOverdraw().
+///@return The index of the first triangle of each cluster, and the number of
+/// triangles at the end.
+std::vector<uint32_t> MakeOverdrawClusters(const std::vector<uint32_t>& indices, unsigned int numVertices,
+  float threshold)
+{
+  const uint32_t numTriangles = indices.size() / 3;
+  std::vector<uint8_t> misses(numTriangles);
+  VertexCache cache(numVertices, DEFAULT_VERTEX_CACHE_SIZE);
+  for (uint32_t t = 0; t < numTriangles; ++t)
+  {
+    for (uint32_t i = t * 3; i < t * 3 + 3; ++i)
+    {
+      misses[t] += cache.Use(indices[i]);
+    }
+  }
+
+  // Where none of the vertices of a triangle are in the cache, the triangles
+  // before and after it may be drawn in either order at no cost.
+  std::vector<uint32_t> hardBoundaries;
+  for (uint32_t t = 0; t < numTriangles; ++t)
+  {
+    if (t == 0 || misses[t] == 3)
+    {
+      hardBoundaries.push_back(t);
+    }
+  }
+  hardBoundaries.push_back(numTriangles);
+
+  // Within those, a cluster may be ended as soon as its ACMR - starting from
+  // an empty cache - is within the threshold of that of the original order.
+  std::vector<uint32_t> clusters;
+  for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+  {
+    const uint32_t begin = hardBoundaries[h];
+    const uint32_t end = hardBoundaries[h + 1];
+    unsigned int numMisses = 0;
+    for (uint32_t t = begin; t < end; ++t)
+    {
+      numMisses += misses[t];
+    }
+    const float targetMisses = threshold * numMisses / (end - begin);
+
+    clusters.push_back(begin);
+    cache.Flush();
+    numMisses = 0;
+    for (uint32_t t = begin; t < end; ++t)
+    {
+      for (uint32_t i = t * 3; i < t * 3 + 3; ++i)
+      {
+        numMisses += cache.Use(indices[i]);
+      }
+
+      const uint32_t numClusterTriangles = t + 1 - clusters.back();
+      if (t + 1 < end && numMisses <= targetMisses * numClusterTriangles)
+      {
+        clusters.push_back(t + 1);
+        cache.Flush();
+        numMisses = 0;
+      }
+    }
+  }
+  clusters.push_back(numTriangles);
+  return clusters;
+}
+
+///@return The hash of the size and contents of @a values, following @a seed.
+template <typename Array>
+uint64_t HashVector(const Array& values, uint64_t seed)
+{
+  const uint64_t size = values.size();
+  seed = Hash64(&size, sizeof(size), seed);
+  return Hash64(values.data(), values.size() * sizeof(typename Array::value_type), seed);
+}
+
+///@return Whether @a a and @a b are of the same size and contents, byte for byte.
+template <typename Array>
+bool EqualVectors(const Array& a, const Array& b)
+{
+  return a.size() == b.size() &&
+    (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(typename Array::value_type)) == 0);
+}
+
+uint64_t HashMesh(const Mesh& mesh)
+{
+  uint64_t hash = HashVector(mesh.m_Positions, 0);
+  hash = HashVector(mesh.m_Normals, hash);
+  hash = HashVector(mesh.m_Tangents, hash);
+  hash = HashVector(mesh.m_Textures, hash);
+  hash = HashVector(mesh.m_Indices, hash);
+  for (auto& lod : mesh.m_Lods)
+  {
+    hash = HashVector(lod.m_Indices, hash);
+  }
+  hash = HashVector(mesh.m_Joints0, hash);
+  hash = HashVector(mesh.m_Weights0, hash);
+  for (auto& bs : mesh.m_BlendShapes)
+  {
+    hash = Hash64(bs.m_Name.data(), bs.m_Name.size(), hash);
+    hash = HashVector(bs.m_Positions, hash);
+    hash = HashVector(bs.m_Normals, hash);
+    hash = HashVector(bs.m_Tangents, hash);
+  }
+  return hash;
+}
+
+bool EqualMeshes(const Mesh& a, const Mesh& b)
+{
+  if (a.m_Skeleton != b.m_Skeleton || a.m_MorphMethod != b.m_MorphMethod ||
+    a.m_Lods.size() != b.m_Lods.size() || a.m_BlendShapes.size() != b.m_BlendShapes.size() ||
+    !EqualVectors(a.m_Positions, b.m_Positions) || !EqualVectors(a.m_Normals, b.m_Normals) ||
+    !EqualVectors(a.m_Tangents, b.m_Tangents) || !EqualVectors(a.m_Textures, b.m_Textures) ||
+    !EqualVectors(a.m_Indices, b.m_Indices) || !EqualVectors(a.m_Joints0, b.m_Joints0) ||
+    !EqualVectors(a.m_Weights0, b.m_Weights0))
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < a.m_Lods.size(); ++i)
+  {
+    if (a.m_Lods[i].m_Error != b.m_Lods[i].m_Error || !EqualVectors(a.m_Lods[i].m_Indices, b.m_Lods[i].m_Indices))
+    {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < a.m_BlendShapes.size(); ++i)
+  {
+    auto& bsa = a.m_BlendShapes[i];
+    auto& bsb = b.m_BlendShapes[i];
+    if (bsa.m_Name != bsb.m_Name || bsa.m_Weight != bsb.m_Weight ||
+      !EqualVectors(bsa.m_Positions, bsb.m_Positions) || !EqualVectors(bsa.m_Normals, bsb.m_Normals) ||
+      !EqualVectors(bsa.m_Tangents, bsb.m_Tangents))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+///@return The size of the vertex and index data of @a mesh, as held in memory.
+size_t GetMeshDataSize(const Mesh& mesh)
+{
+  size_t size = (mesh.m_Positions.size() + mesh.m_Normals.size() + mesh.m_Tangents.size()) * sizeof(Vector3) +
+    mesh.m_Textures.size() * sizeof(Vector2) + mesh.m_Indices.size() * sizeof(uint32_t) +
+    (mesh.m_Joints0.size() + mesh.m_Weights0.size()) * sizeof(Vector4);
+  for (auto& lod : mesh.m_Lods)
+  {
+    size += lod.m_Indices.size() * sizeof(uint32_t);
+  }
+  for (auto& bs : mesh.m_BlendShapes)
+  {
+    size += (bs.m_Positions.size() + bs.m_Normals.size() + bs.m_Tangents.size()) * sizeof(Vector3);
+  }
+  return size;
+}
+
+} // namespace
+
+std::vector<Mesh> SplitMesh(const Mesh& mesh, unsigned int maxVertices)
+{
+  std::vector<Mesh> parts;
+  const size_t numVertices = mesh.m_Positions.size();
+  if (numVertices <= maxVertices || maxVertices < 3)
+  {
+    return parts;
+  }
+
+  std::vector<uint32_t> localIds(numVertices, INVALID_INDEX);
+  std::vector<uint32_t> vertices; // of the current part, by their local id.
+  std::vector<uint32_t> indices;
+  auto addPart = [&]() {
+    parts.push_back(MakePart(mesh, vertices));
+    parts.back().m_Indices.swap(indices);
+
+    for (auto v : vertices)
+    {
+      localIds[v] = INVALID_INDEX;
+    }
+    vertices.clear();
+  };
+
+  auto& source = mesh.m_Indices;
+  for (size_t i = 0; i + 3 <= source.size(); i += 3)
+  {
+    unsigned int numNewVertices = 0;
+    for (size_t j = i; j < i + 3; ++j)
+    {
+      numNewVertices += localIds[source[j]] == INVALID_INDEX;
+    }
+
+    if (vertices.size() + numNewVertices > maxVertices)
+    {
+      addPart();
+    }
+
+    for (size_t j = i; j < i + 3; ++j)
+    {
+      uint32_t& localId = localIds[source[j]];
+      if (localId == INVALID_INDEX)
+      {
+        localId = vertices.size();
+        vertices.push_back(source[j]);
+      }
+      indices.push_back(localId);
+    }
+  }
+
+  if (!indices.empty())
+  {
+    addPart();
+  }
+  return parts;
+}
+
+unsigned int SplitMeshes(Scene3D& scene, unsigned int maxVertices)
+{
+  unsigned int numSplit = 0;
+  const unsigned int numMeshes = scene.GetNumMeshes();
+  const unsigned int numNodes = scene.GetNumNodes();
+  for (unsigned int m = 0; m < numMeshes; ++m)
+  {
+    Mesh& mesh = *scene.GetMesh(m);
+    if (!HasValidIndices(mesh))
+    {
+      std::cout << "WARNING: Mesh " << m << " has indices of vertices that it doesn't have; not splitting it." <<
+        std::endl;
+      continue;
+    }
+
+    auto parts = SplitMesh(mesh, maxVertices);
+    if (parts.empty())
+    {
+      continue;
+    }
+
+    std::cout << "Splitting mesh " << m << " of " << mesh.m_Positions.size() << " vertices into " <<
+      parts.size() << " part(s)." << std::endl;
+    ++numSplit;
+
+    mesh = std::move(parts.front());
+    const unsigned int firstMeshId = scene.GetNumMeshes();
+    for (auto i = parts.begin() + 1; i != parts.end(); ++i)
+    {
+      scene.AddMesh(std::move(*i));
+    }
+
+    for (unsigned int n = 0; n < numNodes; ++n)
+    {
+      Node3D* node = scene.GetNode(n);
+      if (node->m_MeshId != m)
+      {
+        continue;
+      }
+
+      for (unsigned int p = 1; p < parts.size(); ++p)
+      {
+        Node3D* partNode = scene.CreateNode(node);
+        partNode->m_Name = node->m_Name + "_part" + std::to_string(p);
+        partNode->m_MeshId = firstMeshId + p - 1;
+        partNode->m_MaterialIdx = node->m_MaterialIdx;
+        partNode->m_isBlendEnabled = node->m_isBlendEnabled;
+        partNode->m_Skeleton = node->m_Skeleton;
+        scene.AddNode(partNode);
+      }
+    }
+  }
+  return numSplit;
+}
+
+bool HasValidIndices(const Mesh& mesh)
+{
+  const size_t numVertices = mesh.m_Positions.size();
+  auto isOutOfRange = [numVertices](uint32_t i) {
+    return i >= numVertices;
+  };
+  return std::none_of(mesh.m_Indices.begin(), mesh.m_Indices.end(), isOutOfRange) &&
+    std::none_of(mesh.m_Lods.begin(), mesh.m_Lods.end(), [&isOutOfRange](const MeshLod& lod) {
+      return std::any_of(lod.m_Indices.begin(), lod.m_Indices.end(), isOutOfRange);
+    });
+}
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, unsigned int numVertices,
+  unsigned int cacheSize)
+{
+  VertexCacheStats stats;
+  if (indices.size() < 3 || numVertices == 0)
+  {
+    return stats;
+  }
+
+  VertexCache cache(numVertices, cacheSize);
+  unsigned int numTransformed = 0;
+  for (auto i : indices)
+  {
+    numTransformed += cache.Use(i);
+  }
+
+  stats.acmr = static_cast<float>(numTransformed) / (indices.size() / 3);
+  stats.atvr = static_cast<float>(numTransformed) / numVertices;
+  return stats;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, unsigned int numVertices)
+{
+  const size_t numTriangles = indices.size() / 3;
+  if (numTriangles < 2 || indices.size() % 3 != 0)
+  {
+    return;
+  }
+
+  static const VertexScores scores;
+  VertexTriangles vertexTriangles(indices, numVertices);
+
+  std::vector<uint32_t> cachePositions(numVertices, INVALID_INDEX);
+  std::vector<float> vertexScores(numVertices);
+  for (unsigned int v = 0; v < numVertices; ++v)
+  {
+    vertexScores[v] = scores.Get(INVALID_INDEX, vertexTriangles.counts[v]);
+  }
+
+  uint32_t best = INVALID_INDEX;
+  float bestScore = -1.f;
+  for (size_t t = 0; t < numTriangles; ++t)
+  {
+    const uint32_t* triangle = indices.data() + t * 3;
+    const float score = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+    if (score > bestScore)
+    {
+      bestScore = score;
+      best = t;
+    }
+  }
+
+  std::vector<bool> drawn(numTriangles, false);
+  size_t nextUndrawn = 0;
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+
+  // The cache has room for the vertices of the next triangle to push the last
+  // ones out, whose scores are then updated, to reflect this.
+  uint32_t cache[SCORING_CACHE_SIZE + 3];
+  unsigned int cacheCount = 0;
+  while (best != INVALID_INDEX)
+  {
+    const uint32_t* triangle = indices.data() + best * 3;
+    result.insert(result.end(), triangle, triangle + 3);
+    drawn[best] = true;
+
+    uint32_t newCache[SCORING_CACHE_SIZE + 3];
+    unsigned int newCacheCount = 0;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      const uint32_t v = triangle[i];
+      if (std::find(newCache, newCache + newCacheCount, v) == newCache + newCacheCount)
+      {
+        newCache[newCacheCount++] = v;
+      }
+      vertexTriangles.Remove(v, best);
+    }
+
+    for (unsigned int i = 0; i < cacheCount; ++i)
+    {
+      const uint32_t v = cache[i];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+      {
+        newCache[newCacheCount++] = v;
+      }
+    }
+
+    for (unsigned int i = 0; i < newCacheCount; ++i)
+    {
+      const uint32_t v = newCache[i];
+      cachePositions[v] = i < SCORING_CACHE_SIZE ? i : INVALID_INDEX;
+      vertexScores[v] = scores.Get(cachePositions[v], vertexTriangles.counts[v]);
+    }
+
+    cacheCount = std::min(newCacheCount, SCORING_CACHE_SIZE);
+    std::copy(newCache, newCache + cacheCount, cache);
+
+    // Only the triangles of the vertices in the cache are considered; theirs
+    // are the only scores that have changed.
+    best = INVALID_INDEX;
+    bestScore = -1.f;
+    for (unsigned int i = 0; i < newCacheCount; ++i)
+    {
+      const uint32_t v = newCache[i];
+      auto iTriangle = vertexTriangles.triangles.begin() + vertexTriangles.offsets[v];
+      for (auto iEnd = iTriangle + vertexTriangles.counts[v]; iTriangle != iEnd; ++iTriangle)
+      {
+        const uint32_t* candidate = indices.data() + *iTriangle * 3;
+        const float score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+        if (score > bestScore)
+        {
+          bestScore = score;
+          best = *iTriangle;
+        }
+      }
+    }
+
+    if (best == INVALID_INDEX)
+    {
+      // Nothing in the cache has triangles left; carry on with the first one
+      // that hasn't been drawn.
+      while (nextUndrawn < numTriangles && drawn[nextUndrawn])
+      {
+        ++nextUndrawn;
+      }
+      best = nextUndrawn < numTriangles ? nextUndrawn : INVALID_INDEX;
+    }
+  }
+
+  indices.swap(result);
+}
+
+OverdrawStats AnalyzeOverdraw(const std::vector<uint32_t>& indices, const VertexArray<Vector3>& positions,
+  unsigned int viewSize)
+{
+  OverdrawStats stats;
+  if (indices.size() < 3 || positions.empty() || viewSize == 0)
+  {
+    return stats;
+  }
+
+  Vector3 min = positions[0];
+  Vector3 max = positions[0];
+  for (auto& p : positions)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      min.data[i] = std::min(min.data[i], p.data[i]);
+      max.data[i] = std::max(max.data[i], p.data[i]);
+    }
+  }
+
+  const float infinity = std::numeric_limits<float>::infinity();
+  std::vector<float> depths(viewSize * viewSize);
+  for (unsigned int axis = 0; axis < 3; ++axis)
+  {
+    const unsigned int u = (axis + 1) % 3;
+    const unsigned int v = (axis + 2) % 3;
+    const float extent = std::max(max.data[u] - min.data[u], max.data[v] - min.data[v]);
+    if (extent <= 0.f)
+    {
+      continue;
+    }
+    const float scale = viewSize / extent;
+
+    for (float direction : { -1.f, 1.f })
+    {
+      std::fill(depths.begin(), depths.end(), infinity);
+      for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+      {
+        const Vector3* p[] = { &positions[indices[i]], &positions[indices[i + 1]], &positions[indices[i + 2]] };
+        const Vector3 normal = Cross(*p[1] - *p[0], *p[2] - *p[0]);
+        if (normal.data[axis] * direction >= 0.f)
+        {
+          continue; // facing away from the view.
+        }
+
+        float x[3], y[3], z[3];
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+          x[j] = (p[j]->data[u] - min.data[u]) * scale;
+          y[j] = (p[j]->data[v] - min.data[v]) * scale;
+          z[j] = p[j]->data[axis] * direction;
+        }
+
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area == 0.f)
+        {
+          continue;
+        }
+        if (area < 0.f)
+        {
+          // The winding on screen depends on the view; make it consistent.
+          std::swap(x[1], x[2]);
+          std::swap(y[1], y[2]);
+          std::swap(z[1], z[2]);
+          area = -area;
+        }
+
+        auto toPixel = [viewSize](float f) {
+          return static_cast<int>(Util::clamp(f, 0.f, static_cast<float>(viewSize - 1)));
+        };
+        const int x0 = toPixel(std::min({ x[0], x[1], x[2] }));
+        const int x1 = toPixel(std::max({ x[0], x[1], x[2] }));
+        const int y0 = toPixel(std::min({ y[0], y[1], y[2] }));
+        const int y1 = toPixel(std::max({ y[0], y[1], y[2] }));
+        for (int py = y0; py <= y1; ++py)
+        {
+          const float cy = py + .5f;
+          for (int px = x0; px <= x1; ++px)
+          {
+            const float cx = px + .5f;
+            const float w0 = (x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1]);
+            const float w1 = (x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2]);
+            const float w2 = (x[1] - x[0]) * (cy - y[0]) - (y[1] - y[0]) * (cx - x[0]);
+            if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+            {
+              continue;
+            }
+
+            const float depth = (w0 * z[0] + w1 * z[1] + w2 * z[2]) / area;
+            float& pixel = depths[py * viewSize + px];
+            if (depth < pixel)
+            {
+              stats.numCovered += pixel == infinity;
+              ++stats.numShaded;
+              pixel = depth;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  stats.overdraw = stats.numCovered > 0 ? static_cast<float>(stats.numShaded) / stats.numCovered : 0.f;
+  return stats;
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const VertexArray<Vector3>& positions, float threshold)
+{
+  const size_t numTriangles = indices.size() / 3;
+  if (numTriangles < 2 || indices.size() % 3 != 0)
+  {
+    return;
+  }
+
+  const auto clusters = MakeOverdrawClusters(indices, positions.size(), threshold);
+  const size_t numClusters = clusters.size() - 1;
+  if (numClusters < 2)
+  {
+    return;
+  }
+
+  // The area weighted centroids and normals of the clusters, and the mesh.
+  struct Cluster
+  {
+    Vector3 centroid;
+    Vector3 normal;
+    float area = 0.f;
+    float sortKey = 0.f;
+  };
+  std::vector<Cluster> clusterData(numClusters);
+  Cluster mesh;
+  for (size_t c = 0; c < numClusters; ++c)
+  {
+    Cluster& cluster = clusterData[c];
+    for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+    {
+      const Vector3& p0 = positions[indices[t * 3]];
+      const Vector3& p1 = positions[indices[t * 3 + 1]];
+      const Vector3& p2 = positions[indices[t * 3 + 2]];
+      const Vector3 normal = Cross(p1 - p0, p2 - p0);
+      const float area = sqrtf(normal.squareMagnitude());
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        cluster.centroid.data[i] += (p0.data[i] + p1.data[i] + p2.data[i]) * area;
+        cluster.normal.data[i] += normal.data[i];
+      }
+      cluster.area += area;
+    }
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      mesh.centroid.data[i] += cluster.centroid.data[i];
+    }
+    mesh.area += cluster.area;
+  }
+
+  if (mesh.area <= 0.f)
+  {
+    return;
+  }
+
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    mesh.centroid.data[i] /= mesh.area * 3.f;
+  }
+
+  // The clusters that are furthest out from the centroid of the mesh, in the
+  // direction that they face, are the likeliest occluders.
+  for (auto& cluster : clusterData)
+  {
+    const float normalLength = sqrtf(cluster.normal.squareMagnitude());
+    if (cluster.area > 0.f && normalLength > 0.f)
+    {
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        cluster.centroid.data[i] /= cluster.area * 3.f;
+      }
+      cluster.sortKey = Dot(cluster.centroid - mesh.centroid, cluster.normal) / normalLength;
+    }
+  }
+
+  std::vector<uint32_t> order(numClusters);
+  for (uint32_t c = 0; c < numClusters; ++c)
+  {
+    order[c] = c;
+  }
+  std::stable_sort(order.begin(), order.end(), [&clusterData](uint32_t a, uint32_t b) {
+    return clusterData[a].sortKey > clusterData[b].sortKey;
+  });
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (auto c : order)
+  {
+    result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+  }
+  indices.swap(result);
+}
+
+unsigned int OptimizeVertexFetch(Mesh& mesh)
+{
+  const size_t numVertices = mesh.m_Positions.size();
+  if (mesh.m_Indices.empty())
+  {
+    return 0;
+  }
+
+  std::vector<uint32_t> newIds(numVertices, INVALID_INDEX);
+  std::vector<uint32_t> vertices; // by their new id.
+  vertices.reserve(numVertices);
+  for (auto& i : mesh.m_Indices)
+  {
+    uint32_t& newId = newIds[i];
+    if (newId == INVALID_INDEX)
+    {
+      newId = vertices.size();
+      vertices.push_back(i);
+    }
+    i = newId;
+  }
+
+  // Levels of detail only use vertices of the full detail mesh.
+  for (auto& lod : mesh.m_Lods)
+  {
+    for (auto& i : lod.m_Indices)
+    {
+      i = newIds[i];
+    }
+  }
+
+  Mesh remapped = MakePart(mesh, vertices);
+  remapped.m_Indices.swap(mesh.m_Indices);
+  remapped.m_Lods.swap(mesh.m_Lods);
+  mesh = std::move(remapped);
+  return numVertices - vertices.size();
+}
+
+DeduplicationStats DeduplicateMeshes(Scene3D& scene, WorkerPool* workers)
+{
+  DeduplicationStats stats;
+  const unsigned int numMeshes = scene.GetNumMeshes();
+  stats.numMeshes = numMeshes;
+
+  std::vector<uint64_t> hashes(numMeshes);
+  WorkerPool::Execute(workers, numMeshes, [&scene, &hashes](unsigned int i) {
+    hashes[i] = HashMesh(*scene.GetMesh(i));
+  });
+
+  // Map each mesh to the first one that's identical to it - possibly itself -
+  // among those with the same hash.
+  std::unordered_multimap<uint64_t, unsigned int> unique;
+  std::vector<unsigned int> remap(numMeshes);
+  std::vector<bool> remove(numMeshes, false);
+  for (unsigned int i = 0; i < numMeshes; ++i)
+  {
+    const Mesh& mesh = *scene.GetMesh(i);
+    remap[i] = i;
+    auto range = unique.equal_range(hashes[i]);
+    for (auto iFind = range.first; iFind != range.second; ++iFind)
+    {
+      if (EqualMeshes(*scene.GetMesh(iFind->second), mesh))
+      {
+        remap[i] = iFind->second;
+        break;
+      }
+    }
+
+    if (remap[i] == i)
+    {
+      unique.emplace(hashes[i], i);
+    }
+    else
+    {
+      remove[i] = true;
+      stats.numBytesSaved += GetMeshDataSize(mesh);
+    }
+  }
+
+  // Account for the meshes removed before each of the survivors.
+  std::vector<unsigned int> newIds(numMeshes);
+  unsigned int numUnique = 0;
+  for (unsigned int i = 0; i < numMeshes; ++i)
+  {
+    newIds[i] = remove[i] ? newIds[remap[i]] : numUnique++;
+  }
+  stats.numUnique = numUnique;
+
+  if (numUnique < numMeshes)
+  {
+    for (unsigned int n = 0; n < scene.GetNumNodes(); ++n)
+    {
+      Node3D* node = scene.GetNode(n);
+      if (node->HasMesh())
+      {
+        node->m_MeshId = newIds[node->m_MeshId];
+      }
+    }
+    scene.RemoveMeshes(remove);
+  }
+  return stats;
+}
@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <unordered_set>
+
+namespace
+{
+
+using Point = std::array<double, 3>;
+
+// The weights of the squared differences of the attributes of vertices in the
+// error of a collapse, which is otherwise a squared distance relative to the
+// extent of the mesh.
+const double NORMAL_WEIGHT = 1e-4;
+const double TEXTURE_WEIGHT = 1e-2;
+const double SKIN_WEIGHT = 1e-2;
+
+// The weight of the planes that keep the border of the mesh in place, relative
+// to the ones of its triangles.
+const double BORDER_WEIGHT = 10.;
+
+enum VertexKind : uint8_t
+{
+  INTERIOR,
+  BORDER, // only moves along the border.
+  LOCKED, // on a seam, or a complex border; never moves.
+};
+
+Point Subtract(const Point& a, const Point& b)
+{
+  return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+}
+
+Point Cross(const Point& a, const Point& b)
+{
+  return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+double Dot(const Point& a, const Point& b)
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+uint64_t MakeEdgeKey(uint32_t a, uint32_t b)
+{
+  return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+///@brief The sum of the (weighted) squared distances of a point from a set of
+/// planes, as p'Ap + 2b'p + c, where A is symmetric.
+struct Quadric
+{
+  double a00 = 0., a11 = 0., a22 = 0., a01 = 0., a02 = 0., a12 = 0.;
+  double b0 = 0., b1 = 0., b2 = 0.;
+  double c = 0.;
+  double weight = 0.;
+
+  ///@brief Adds the plane with the unit @a normal, through @a p, with the weight @a w.
+  void AddPlane(const Point& normal, const Point& p, double w)
+  {
+    const double d = -Dot(normal, p);
+    a00 += w * normal[0] * normal[0];
+    a11 += w * normal[1] * normal[1];
+    a22 += w * normal[2] * normal[2];
+    a01 += w * normal[0] * normal[1];
+    a02 += w * normal[0] * normal[2];
+    a12 += w * normal[1] * normal[2];
+    b0 += w * normal[0] * d;
+    b1 += w * normal[1] * d;
+    b2 += w * normal[2] * d;
+    c += w * d * d;
+    weight += w;
+  }
+
+  void Add(const Quadric& q)
+  {
+    a00 += q.a00;
+    a11 += q.a11;
+    a22 += q.a22;
+    a01 += q.a01;
+    a02 += q.a02;
+    a12 += q.a12;
+    b0 += q.b0;
+    b1 += q.b1;
+    b2 += q.b2;
+    c += q.c;
+    weight += q.weight;
+  }
+
+  ///@return The mean squared distance of @a p from the planes.
+  double Evaluate(const Point& p) const
+  {
+    const double x = p[0], y = p[1], z = p[2];
+    const double e = a00 * x * x + a11 * y * y + a22 * z * z + 2. * (a01 * x * y + a02 * x * z + a12 * y * z) +
+      2. * (b0 * x + b1 * y + b2 * z) + c;
+    return weight > 0. && e > 0. ? e / weight : 0.;
+  }
+};
+
+///@brief The state of the simplification of a mesh.
+class Simplifier
+{
+public:
+  Simplifier(const Mesh& mesh, const std::vector<uint32_t>& indices)
+  : m_Mesh(mesh),
+    m_Positions(mesh.m_Positions.size()),
+    m_Kinds(mesh.m_Positions.size()),
+    m_Quadrics(mesh.m_Positions.size())
+  {
+    NormalizePositions();
+    FindSeams();
+    Classify(indices);
+    InitQuadrics(indices);
+  }
+
+  ///@brief Collapses edges of @a indices until there are no more than
+  /// @a targetNumIndices, or there are no more valid collapses.
+  ///@return The greatest error of the collapses.
+  double Run(std::vector<uint32_t>& indices, size_t targetNumIndices)
+  {
+    struct Collapse
+    {
+      uint32_t u; // collapsed onto v.
+      uint32_t v;
+      double cost;
+    };
+
+    const size_t numVertices = m_Positions.size();
+    std::vector<uint32_t> remap(numVertices);
+    for (uint32_t i = 0; i < numVertices; ++i)
+    {
+      remap[i] = i;
+    }
+
+    double maxCost = 0.;
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched;
+    bool first = true;
+    while (indices.size() > targetNumIndices)
+    {
+      if (!first)
+      {
+        Classify(indices);
+      }
+      first = false;
+      BuildAdjacency(indices);
+
+      collapses.clear();
+      for (size_t i = 0; i < indices.size(); i += 3)
+      {
+        for (unsigned int e = 0; e < 3; ++e)
+        {
+          const uint32_t a = indices[i + e];
+          const uint32_t b = indices[i + (e + 1) % 3];
+          if (CanCollapse(a, b))
+          {
+            collapses.push_back({ a, b, GetCost(a, b) });
+          }
+          if (CanCollapse(b, a))
+          {
+            collapses.push_back({ b, a, GetCost(b, a) });
+          }
+        }
+      }
+
+      std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+        return a.cost < b.cost || (a.cost == b.cost && (a.u < b.u || (a.u == b.u && a.v < b.v)));
+      });
+
+      // Each collapse locks the neighbourhood of the vertex that it moves, for
+      // the rest of the pass, so that the adjacency and the quadrics of the
+      // ones after it remain valid.
+      const size_t numToRemove = (indices.size() - targetNumIndices + 2) / 3;
+      size_t numRemoved = 0;
+      touched.assign(numVertices, false);
+      for (auto& c : collapses)
+      {
+        if (numRemoved >= numToRemove)
+        {
+          break;
+        }
+
+        if (touched[c.u] || touched[c.v] || Flips(c.u, c.v, indices))
+        {
+          continue;
+        }
+
+        remap[c.u] = c.v;
+        m_Quadrics[c.v].Add(m_Quadrics[c.u]);
+        maxCost = std::max(maxCost, c.cost);
+
+        auto iTriangle = m_Triangles.begin() + m_Offsets[c.u];
+        for (auto iEnd = iTriangle + m_Counts[c.u]; iTriangle != iEnd; ++iTriangle)
+        {
+          const uint32_t* triangle = indices.data() + *iTriangle * 3;
+          bool hasV = false;
+          for (unsigned int j = 0; j < 3; ++j)
+          {
+            touched[triangle[j]] = true;
+            hasV = hasV || triangle[j] == c.v;
+          }
+          numRemoved += hasV;
+        }
+      }
+
+      if (numRemoved == 0)
+      {
+        break;
+      }
+
+      size_t numIndices = 0;
+      for (size_t i = 0; i < indices.size(); i += 3)
+      {
+        const uint32_t a = remap[indices[i]];
+        const uint32_t b = remap[indices[i + 1]];
+        const uint32_t c = remap[indices[i + 2]];
+        if (a != b && b != c && c != a)
+        {
+          indices[numIndices++] = a;
+          indices[numIndices++] = b;
+          indices[numIndices++] = c;
+        }
+      }
+      indices.resize(numIndices);
+
+      for (uint32_t i = 0; i < numVertices; ++i)
+      {
+        remap[i] = i;
+      }
+    }
+    return maxCost;
+  }
+
+private:
+  void NormalizePositions()
+  {
+    auto& positions = m_Mesh.m_Positions;
+    if (positions.empty())
+    {
+      return;
+    }
+
+    Vector3 min = positions[0];
+    Vector3 max = positions[0];
+    for (auto& p : positions)
+    {
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        min.data[i] = std::min(min.data[i], p.data[i]);
+        max.data[i] = std::max(max.data[i], p.data[i]);
+      }
+    }
+
+    const double extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+    const double scale = extent > 0. ? 1. / extent : 1.;
+    for (size_t v = 0; v < positions.size(); ++v)
+    {
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        m_Positions[v][i] = (positions[v].data[i] - min.data[i]) * scale;
+      }
+    }
+  }
+
+  ///@brief Locks the vertices which share their position with others.
+  void FindSeams()
+  {
+    auto& positions = m_Mesh.m_Positions;
+    std::vector<uint32_t> order(positions.size());
+    for (uint32_t i = 0; i < order.size(); ++i)
+    {
+      order[i] = i;
+    }
+
+    auto less = [&positions](uint32_t a, uint32_t b) {
+      auto& pa = positions[a];
+      auto& pb = positions[b];
+      return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && pa.z < pb.z)));
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    m_Seams.assign(positions.size(), false);
+    for (size_t i = 1; i < order.size(); ++i)
+    {
+      if (!less(order[i - 1], order[i]))
+      {
+        m_Seams[order[i - 1]] = true;
+        m_Seams[order[i]] = true;
+      }
+    }
+  }
+
+  ///@brief Finds the border edges of @a indices, and the kinds of the vertices.
+  void Classify(const std::vector<uint32_t>& indices)
+  {
+    m_Edges.clear();
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+      for (unsigned int e = 0; e < 3; ++e)
+      {
+        m_Edges.insert(MakeEdgeKey(indices[i + e], indices[i + (e + 1) % 3]));
+      }
+    }
+
+    std::vector<uint8_t> numBorderEdges(m_Positions.size(), 0);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+      for (unsigned int e = 0; e < 3; ++e)
+      {
+        const uint32_t a = indices[i + e];
+        const uint32_t b = indices[i + (e + 1) % 3];
+        if (IsBorderEdge(a, b))
+        {
+          numBorderEdges[a] = std::min(numBorderEdges[a] + 1, 255);
+          numBorderEdges[b] = std::min(numBorderEdges[b] + 1, 255);
+        }
+      }
+    }
+
+    for (size_t v = 0; v < m_Positions.size(); ++v)
+    {
+      m_Kinds[v] = m_Seams[v] || numBorderEdges[v] > 2 ? LOCKED : numBorderEdges[v] > 0 ? BORDER : INTERIOR;
+    }
+  }
+
+  ///@return Whether the edge from @a a to @a b only has a triangle on one side.
+  bool IsBorderEdge(uint32_t a, uint32_t b) const
+  {
+    return m_Edges.find(MakeEdgeKey(b, a)) == m_Edges.end();
+  }
+
+  void InitQuadrics(const std::vector<uint32_t>& indices)
+  {
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+      const uint32_t* triangle = indices.data() + i;
+      Point normal = Cross(Subtract(m_Positions[triangle[1]], m_Positions[triangle[0]]),
+        Subtract(m_Positions[triangle[2]], m_Positions[triangle[0]]));
+      const double length = sqrt(Dot(normal, normal));
+      if (length <= 0.)
+      {
+        continue;
+      }
+
+      for (auto& n : normal)
+      {
+        n /= length;
+      }
+
+      const double area = length * .5;
+      for (unsigned int j = 0; j < 3; ++j)
+      {
+        m_Quadrics[triangle[j]].AddPlane(normal, m_Positions[triangle[0]], area);
+      }
+
+      // Keep the border in place, with the plane through it, perpendicular to the triangle.
+      for (unsigned int e = 0; e < 3; ++e)
+      {
+        const uint32_t a = triangle[e];
+        const uint32_t b = triangle[(e + 1) % 3];
+        if (!IsBorderEdge(a, b))
+        {
+          continue;
+        }
+
+        const Point edge = Subtract(m_Positions[b], m_Positions[a]);
+        Point borderNormal = Cross(edge, normal);
+        const double borderLength = sqrt(Dot(borderNormal, borderNormal));
+        if (borderLength > 0.)
+        {
+          for (auto& n : borderNormal)
+          {
+            n /= borderLength;
+          }
+
+          const double weight = borderLength * BORDER_WEIGHT;
+          m_Quadrics[a].AddPlane(borderNormal, m_Positions[a], weight);
+          m_Quadrics[b].AddPlane(borderNormal, m_Positions[a], weight);
+        }
+      }
+    }
+  }
+
+  ///@brief Builds the lists of the triangles of @a indices that each vertex is used by.
+  void BuildAdjacency(const std::vector<uint32_t>& indices)
+  {
+    const size_t numVertices = m_Positions.size();
+    m_Offsets.assign(numVertices, 0);
+    m_Counts.assign(numVertices, 0);
+    m_Triangles.resize(indices.size());
+    for (auto i : indices)
+    {
+      ++m_Counts[i];
+    }
+
+    uint32_t offset = 0;
+    for (size_t v = 0; v < numVertices; ++v)
+    {
+      m_Offsets[v] = offset;
+      offset += m_Counts[v];
+      m_Counts[v] = 0;
+    }
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      const uint32_t v = indices[i];
+      m_Triangles[m_Offsets[v] + m_Counts[v]] = i / 3;
+      ++m_Counts[v];
+    }
+  }
+
+  bool CanCollapse(uint32_t u, uint32_t v) const
+  {
+    switch (m_Kinds[u])
+    {
+    case INTERIOR:
+      return true;
+    case BORDER:
+      return IsBorderEdge(u, v) || IsBorderEdge(v, u);
+    default:
+      return false;
+    }
+  }
+
+  ///@return The squared error of moving vertex @a u onto @a v.
+  double GetCost(uint32_t u, uint32_t v) const
+  {
+    double cost = m_Quadrics[u].Evaluate(m_Positions[v]);
+
+    auto& normals = m_Mesh.m_Normals;
+    if (normals.size() == m_Positions.size())
+    {
+      const Vector3 delta = normals[u] - normals[v];
+      cost += delta.squareMagnitude() * NORMAL_WEIGHT;
+    }
+
+    auto& textures = m_Mesh.m_Textures;
+    if (textures.size() == m_Positions.size())
+    {
+      const double dx = textures[u].x - textures[v].x;
+      const double dy = textures[u].y - textures[v].y;
+      cost += (dx * dx + dy * dy) * TEXTURE_WEIGHT;
+    }
+
+    if (m_Mesh.m_Joints0.size() == m_Positions.size() && m_Mesh.m_Weights0.size() == m_Positions.size())
+    {
+      const double distance = GetSkinDistance(u, v) + GetSkinDistance(v, u);
+      cost += distance * distance * .25 * SKIN_WEIGHT;
+    }
+    return cost;
+  }
+
+  ///@return The sum of the differences of the weights of the joints of @a u,
+  /// from those of the same joints of @a v.
+  double GetSkinDistance(uint32_t u, uint32_t v) const
+  {
+    auto& joints = m_Mesh.m_Joints0;
+    auto& weights = m_Mesh.m_Weights0;
+    double distance = 0.;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+      float weight = 0.f;
+      for (unsigned int j = 0; j < 4; ++j)
+      {
+        if (joints[v].data[j] == joints[u].data[i])
+        {
+          weight += weights[v].data[j];
+        }
+      }
+      distance += fabs(weights[u].data[i] - weight);
+    }
+    return distance;
+  }
+
+  ///@return Whether moving @a u onto @a v would turn any of its triangles around.
+  bool Flips(uint32_t u, uint32_t v, const std::vector<uint32_t>& indices) const
+  {
+    auto iTriangle = m_Triangles.begin() + m_Offsets[u];
+    for (auto iEnd = iTriangle + m_Counts[u]; iTriangle != iEnd; ++iTriangle)
+    {
+      const uint32_t* triangle = indices.data() + *iTriangle * 3;
+      if (triangle[0] == v || triangle[1] == v || triangle[2] == v)
+      {
+        continue; // this one is removed.
+      }
+
+      Point p[3];
+      Point q[3];
+      for (unsigned int j = 0; j < 3; ++j)
+      {
+        p[j] = m_Positions[triangle[j]];
+        q[j] = m_Positions[triangle[j] == u ? v : triangle[j]];
+      }
+
+      const Point before = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+      const Point after = Cross(Subtract(q[1], q[0]), Subtract(q[2], q[0]));
+      if (Dot(before, after) <= 0.)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const Mesh& m_Mesh;
+  std::vector<Point> m_Positions;  // normalized to the extent of the mesh.
+  std::vector<bool> m_Seams;
+  std::vector<uint8_t> m_Kinds;    // VertexKind
+  std::vector<Quadric> m_Quadrics;
+  std::unordered_set<uint64_t> m_Edges; // of the triangles, in their winding order.
+
+  // The triangles that each vertex is used by.
+  std::vector<uint32_t> m_Offsets;
+  std::vector<uint32_t> m_Counts;
+  std::vector<uint32_t> m_Triangles;
+};
+
+}
+
+std::vector<uint32_t> SimplifyIndices(const Mesh& mesh, const std::vector<uint32_t>& indices,
+  size_t targetNumIndices, float& error)
+{
+  error = 0.f;
+  std::vector<uint32_t> result(indices);
+  if (result.size() <= targetNumIndices || result.size() % 3 != 0 || mesh.m_Positions.empty())
+  {
+    return result;
+  }
+
+  Simplifier simplifier(mesh, result);
+  error = static_cast<float>(sqrt(simplifier.Run(result, targetNumIndices)));
+  return result;
+}
+
+unsigned int GenerateLods(Mesh& mesh, unsigned int numLods, float ratio)
+{
+  mesh.m_Lods.clear();
+  float error = 0.f;
+  for (unsigned int l = 0; l < numLods; ++l)
+  {
+    const std::vector<uint32_t>& previous = mesh.m_Lods.empty() ? mesh.m_Indices : mesh.m_Lods.back().m_Indices;
+    const size_t targetNumIndices = static_cast<size_t>(previous.size() / 3 * ratio) * 3;
+    float lodError;
+    auto indices = SimplifyIndices(mesh, previous, targetNumIndices, lodError);
+    if (indices.size() >= previous.size())
+    {
+      break;
+    }
+
+    error += lodError;
+    MeshLod lod;
+    lod.m_Indices.swap(indices);
+    lod.m_Error = error;
+    mesh.m_Lods.push_back(std::move(lod));
+  }
+  return mesh.m_Lods.size();
+}
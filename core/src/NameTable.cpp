@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "NameTable.h"
+#include "Node3D.h"
+
+unsigned int NameTable::Intern(const std::string& name)
+{
+  auto iInsert = m_Ids.emplace(name, m_ValidNames.size());
+  if (iInsert.second)
+  {
+    m_ValidNames.push_back(Node3D::MakeValidName(name));
+  }
+  return iInsert.first->second;
+}
+
+const std::string& NameTable::GetValidName(unsigned int id) const
+{
+  return m_ValidNames[id];
+}
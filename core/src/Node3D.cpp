@@ -18,18 +18,29 @@
 #include "Node3D.h"
 #include "Util.h"
 #include <numeric>
-#include <regex>
-
-namespace
-{
-const std::regex NODE_NAME_REGEX = std::regex("[\\s:]");
-}
 
 const Node3D::Predicate Node3D::DEFAULT_END_VISIT_PREDICATE = [](const Node3D&) { return false; };
 
 std::string Node3D::MakeValidName(const std::string& name)
 {
-    return std::regex_replace(name, NODE_NAME_REGEX, "_");
+    // Replaces whitespace and colons with underscores.
+    std::string result(name);
+    for (auto& c : result)
+    {
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\v':
+        case '\f':
+        case '\r':
+        case ':':
+            c = '_';
+            break;
+        }
+    }
+    return result;
 }
 
 Node3D::Node3D(Node3D *eParent)
@@ -42,6 +53,7 @@ Node3D::Node3D(Node3D *eParent)
     }
 
     m_Index = -1;
+    m_NameId = -1;
     m_MaterialIdx = 0;
     m_isBlendEnabled = false;
 }
@@ -51,6 +63,20 @@ Node3D::~Node3D()
     //dtor
 }
 
+void Node3D::ChildList::push_back(Node3D* node)
+{
+    if (m_Last)
+    {
+        m_Last->m_NextSibling = node;
+    }
+    else
+    {
+        m_First = node;
+    }
+    m_Last = node;
+    ++m_Size;
+}
+
 bool Node3D::IsSkeletonRoot() const
 {
     return m_Skeleton == this;
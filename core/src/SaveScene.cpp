@@ -17,13 +17,22 @@
 
 #include "SaveScene.h"
 #include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Hash.h"
 #include "JsonWriter.h"
 #include "Util.h"
+#include "WorkerPool.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <cstring>
 
 using namespace std;
 
@@ -32,6 +41,12 @@ namespace
 using AnimationDataMap = std::map<std::string, std::string>;
 
 const char* const BLEND_SHAPE_VERSION = "2.0";
+
+///@brief The flags of a mesh in the .dli, which tell how its buffers are encoded.
+enum MeshFlags : unsigned int
+{
+  U32_INDICES = 1 << 1, // otherwise 16 bits.
+};
 }
 
 template <typename T>
@@ -51,9 +66,10 @@ void WriteArrayData(const T(&data)[N], JsonWriter& writer)
     WriteArrayData(data, N, writer);
 }
 
+void OptimizeMeshes(Scene3D* scene, const SaveOptions& options, WorkerPool* workers);
 void SaveNodes(Scene3D *scene, JsonWriter& outDli, bool saveMaterials);
 void SaveMeshes(Scene3D *scene, JsonWriter& outDli, ostream &outBin,
-    std::string fileNameBinPath);
+    std::string fileNameBinPath, WorkerPool* workers, const SaveOptions& options);
 void SaveCameras(Scene3D *scene, JsonWriter& outDli);
 void SaveSkeletons(Scene3D *scene, JsonWriter& outDli);
 void SaveLights(Scene3D *scene, JsonWriter& outDli);
@@ -63,9 +79,9 @@ void SaveShaders(Scene3D *scene, JsonWriter& outDli);
 void SaveAnimations(Scene3D *scene, JsonWriter& outDli, std::set<std::string>& animNames);
 void SaveAnimationsBinary(Scene3D *scene, JsonWriter& outDli, std::string outPath, std::set<std::string>& animNames, AnimationDataMap* animationContents);
 void WriteNodeKeyframes(const std::string& property, JsonWriter& outDli,
-  Animation3D *animation, int animationidx, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize);
+  Animation3D *animation, const std::string& nodeName, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize);
 void WriteNodeKeyframesBin(const std::string& url, const std::string& property, JsonWriter& outDli, std::ostream& osBin, unsigned int& offset,
-  Animation3D *animation, int animationidx, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize);
+  Animation3D *animation, const std::string& nodeName, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize);
 
 void JsonScopeGuard(JsonWriter* w)
 {
@@ -107,7 +123,7 @@ bool SaveScene(Scene3D *scene, std::string fileNamePath,
 
 bool ConvertScene(Scene3D* scene, std::string fileNameBin, std::ostream& outDli,
     std::ostream& outBin, bool saveMaterials, bool binaryAnimations,
-    std::map<std::string, std::string>* animationContents)
+    std::map<std::string, std::string>* animationContents, WorkerPool* workers, const SaveOptions& options)
 {
   // If filenameBin is a path, now is a good time to discard all but the filename & extension -
   // the .bin file that we are going to reference must be in the same directory as the .dli.
@@ -121,12 +137,37 @@ bool ConvertScene(Scene3D* scene, std::string fileNameBin, std::ostream& outDli,
         fileNameBin.length() - iDirSeparator - 1);
   }
 
+  if (options.deduplicateMeshes)
+  {
+    const DeduplicationStats stats = DeduplicateMeshes(*scene, workers);
+    const float ratio = stats.numUnique > 0 ? static_cast<float>(stats.numMeshes) / stats.numUnique : 1.f;
+    std::ostringstream log;
+    log << std::fixed << std::setprecision(3) << "Deduplicated meshes: " << stats.numMeshes << " -> " <<
+      stats.numUnique << " (ratio " << ratio << "), " << stats.numBytesSaved << " bytes saved." << std::endl;
+    cout << log.str();
+  }
+
+  if (options.shortIndices)
+  {
+    SplitMeshes(*scene, std::numeric_limits<uint16_t>::max() + 1);
+  }
+  OptimizeMeshes(scene, options, workers);
+
+  cout << "Allocated " << scene->GetNumNodes() << " nodes and " << scene->GetNumMeshes() <<
+    " meshes in " << scene->GetNumAllocations() << " blocks." << std::endl;
+
   // Write scene data.
-  JsonWriter writer(outDli, "  ");
+  const JsonWriter::Format format = options.binary ? JsonWriter::BINARY :
+    options.compact ? JsonWriter::COMPACT : JsonWriter::PRETTY;
+  JsonWriter writer(outDli, "  ", format);
   writer.WriteObject(nullptr);
 
   writer.WriteObject("asset", true);
     writer.WriteValue("version", "1.0");
+    if (options.bufferAlignment > 1)
+    {
+      writer.WriteValue("bufferAlignment", options.bufferAlignment);
+    }
   writer.CloseScope();
 
   writer.WriteValue("scene", 0);
@@ -146,7 +187,7 @@ bool ConvertScene(Scene3D* scene, std::string fileNameBin, std::ostream& outDli,
 
   // Save meshes
   writer.WriteArray("meshes");
-  SaveMeshes(scene, writer, outBin, fileNameBin);
+  SaveMeshes(scene, writer, outBin, fileNameBin, workers, options);
   writer.CloseScope();
 
   SaveSkeletons(scene, writer);
@@ -194,10 +235,89 @@ bool ConvertScene(Scene3D* scene, std::string fileNameBin, std::ostream& outDli,
   }
 
   writer.CloseScope();
-  outDli << std::endl;
+  writer.Flush();
+  if (format == JsonWriter::PRETTY)
+  {
+    outDli << std::endl;
+  }
   return true;
 }
 
+///@brief Performs the optimizations of the meshes of @a scene that @a options
+/// ask for, on @a workers if provided, and logs their results, in the order of
+/// the meshes.
+void OptimizeMeshes(Scene3D* scene, const SaveOptions& options, WorkerPool* workers)
+{
+  if (!options.optimizeVertexCache && !options.optimizeOverdraw && !options.optimizeVertexFetch &&
+    options.numLods == 0)
+  {
+    return;
+  }
+
+  const unsigned int numMeshes = scene->GetNumMeshes();
+  std::vector<std::string> logs(numMeshes);
+  WorkerPool::Execute(workers, numMeshes, [scene, &options, &logs](unsigned int i) {
+    Mesh& mesh = *scene->GetMesh(i);
+    if (!HasValidIndices(mesh))
+    {
+      logs[i] = "WARNING: Mesh " + std::to_string(i) + " has indices of vertices that it doesn't have; " +
+        "not optimizing it.\n";
+      return;
+    }
+
+    const unsigned int numVertices = mesh.m_Positions.size();
+    const VertexCacheStats before = AnalyzeVertexCache(mesh.m_Indices, numVertices);
+    if (options.optimizeVertexCache)
+    {
+      OptimizeVertexCache(mesh.m_Indices, numVertices);
+    }
+
+    OverdrawStats overdrawBefore, overdrawAfter;
+    if (options.optimizeOverdraw)
+    {
+      overdrawBefore = AnalyzeOverdraw(mesh.m_Indices, mesh.m_Positions);
+      OptimizeOverdraw(mesh.m_Indices, mesh.m_Positions, options.overdrawThreshold);
+      overdrawAfter = AnalyzeOverdraw(mesh.m_Indices, mesh.m_Positions);
+    }
+    const VertexCacheStats after = AnalyzeVertexCache(mesh.m_Indices, numVertices);
+
+    GenerateLods(mesh, options.numLods, options.lodRatio);
+    if (options.optimizeVertexCache)
+    {
+      for (auto& lod : mesh.m_Lods)
+      {
+        OptimizeVertexCache(lod.m_Indices, numVertices);
+      }
+    }
+
+    const unsigned int numRemoved = options.optimizeVertexFetch ? OptimizeVertexFetch(mesh) : 0;
+
+    std::ostringstream log;
+    log << std::fixed << std::setprecision(3) << "Mesh " << i << ": ACMR " << before.acmr << " -> " <<
+      after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr;
+    if (options.optimizeOverdraw)
+    {
+      log << ", overdraw " << overdrawBefore.overdraw << " -> " << overdrawAfter.overdraw;
+    }
+    if (numRemoved > 0)
+    {
+      log << ", " << numRemoved << " unused vertices removed";
+    }
+    for (auto& lod : mesh.m_Lods)
+    {
+      log << (&lod == &mesh.m_Lods.front() ? ", levels of detail: " : ", ") << lod.m_Indices.size() / 3 <<
+        " triangles (error " << lod.m_Error << ")";
+    }
+    log << std::endl;
+    logs[i] = log.str();
+  });
+
+  for (auto& log : logs)
+  {
+    cout << log;
+  }
+}
+
 void SaveNodes(Scene3D *scene, JsonWriter& outDli, bool saveMaterials)
 {
   for (unsigned int n = 0; n < scene->GetNumNodes(); n++)
@@ -206,8 +326,7 @@ void SaveNodes(Scene3D *scene, JsonWriter& outDli, bool saveMaterials)
     Node3D *node = scene->GetNode(n);
     if (!node->m_Name.empty())
     {
-      auto validName = Node3D::MakeValidName(node->m_Name);
-      outDli.WriteValue("name", validName.c_str());
+      outDli.WriteValue("name", scene->GetValidName(node->m_NameId).c_str());
     }
     if (!node->m_Matrix.IsIdentity())
     {
@@ -262,234 +381,755 @@ void WriteBufferInternal(const char* name, unsigned int offset, unsigned int siz
   writer.CloseScope();
 }
 
-template <typename T>
-void WriteBuffer(const char* name, unsigned int offset, unsigned int numElems, JsonWriter& writer, unsigned int& outLength)
+///@brief The location of a buffer within the payload of a mesh.
+struct BufferRange
 {
-  outLength = numElems * sizeof(T);
-  WriteBufferInternal(name, offset, outLength, writer);
-}
+  const char* name;
+  unsigned int offset;  // relative to the start of the payload of the mesh.
+  unsigned int length;
+  VertexEncoding::Type encoding = VertexEncoding::FLOAT32;
+  VertexQuantization quantization{};  // if UNORM16.
+  unsigned int stride = 0;  // between the elements of interleaved buffers; otherwise they're tightly packed.
+};
 
-void SaveBlendShapeHeader(const BlendShapeHeader& blendShapeHeader, JsonWriter& writer, ostream &outBin, unsigned int offset, unsigned int& outLenght)
+///@brief The greatest error that the encoding of an attribute has introduced.
+struct EncodingError
 {
-  outLenght = sizeof(blendShapeHeader.width) + sizeof(blendShapeHeader.height);
+  const char* name;
+  VertexEncoding::Type encoding;
+  float error;  // in degrees for octahedral encodings.
+};
 
-  writer.WriteObject("blendShapeHeader", true);
-  writer.WriteValue("version", BLEND_SHAPE_VERSION);
-  writer.WriteValue("byteOffset", offset);
-  writer.WriteValue("byteLength", outLenght);
-  writer.CloseScope();
+///@brief An attribute that has the same value for every vertex, which is
+/// written to the .dli instead of a buffer.
+struct ConstantAttribute
+{
+  const char* name;
+  unsigned int numComponents;
+  float value[4];
+};
 
-  outBin.write(reinterpret_cast<const char*>(&blendShapeHeader.width), sizeof(blendShapeHeader.width));
-  outBin.write(reinterpret_cast<const char*>(&blendShapeHeader.height), sizeof(blendShapeHeader.height));
-}
+///@brief A contiguous part of the payload of a mesh, which is placed into the
+/// .bin as a whole.
+struct PayloadChunk
+{
+  unsigned int offset;  // relative to the start of the payload of the mesh.
+  unsigned int length;
+  bool shareable;       // whether it may be replaced with an identical chunk written earlier.
+  unsigned int padding = 0; // the number of zero bytes written before it, for alignment.
+};
 
-void SaveMeshes(Scene3D *scene, JsonWriter& outDli, ostream &outBin,
-    std::string fileNameBin)
+///@brief The binary data of a mesh, as it's written to the .bin, along with
+/// the buffers that it's made up of. Its encoding doesn't depend on where the
+/// payload ends up in the .bin, so meshes may be encoded concurrently.
+struct MeshPayload
 {
-  unsigned int offset = 0;
-  unsigned int length = 0;
-  for (unsigned int m = 0; m < scene->GetNumMeshes(); m++)
+  unsigned int flags = 0;  // MeshFlags
+  std::vector<char> data;
+  std::vector<BufferRange> buffers;
+  BufferRange blendShapeHeader{ nullptr, 0, 0 };
+  std::vector<std::vector<BufferRange>> blendShapes;
+  std::vector<BufferRange> lods;  // of the indices of each level of detail.
+  BufferRange vertices{ nullptr, 0, 0 };  // the interleaved attributes, if any.
+  std::vector<ConstantAttribute> constants;
+  std::vector<EncodingError> errors;
+
+  ///@brief Calls @a fn with each of the buffers of the payload.
+  template <typename Fn>
+  void ForEachBuffer(Fn fn)
   {
-    const Mesh* mesh = scene->GetMesh(m);
-
-    outDli.WriteObject(nullptr);
-    unsigned int attributes = 0;
-    attributes |= (mesh->m_Indices.size() > 0) ? 1 : 0;
-    attributes |= (mesh->m_Positions.size() > 0) ? 2 : 0;
-    attributes |= (mesh->m_Normals.size() > 0) ? 4 : 0;
-    attributes |= (mesh->m_Textures.size() > 0) ? 8 : 0;
-    attributes |= (mesh->m_Tangents.size() > 0) ? 16 : 0;
-    // NOTE: bit 5 (note the zero-based index) used to be for bitangents.
-    attributes |= (mesh->m_Joints0.size() > 0) ? 64 : 0;
-    attributes |= (mesh->m_Weights0.size() > 0) ? 128 : 0;
+    for (auto& r : buffers)
+    {
+      fn(r);
+    }
 
-    outDli.WriteValue("uri", fileNameBin.c_str());
-    outDli.WriteValue("attributes", attributes);
-    outDli.WriteValue("primitive", "TRIANGLES");
+    if (vertices.length > 0)
+    {
+      fn(vertices);
+    }
 
-    offset += length;
-    WriteBuffer<unsigned short>("indices", offset, mesh->m_Indices.size(), outDli, length);
+    for (auto& r : lods)
+    {
+      fn(r);
+    }
 
-    outBin.write((char*) mesh->m_Indices.data(), length);
+    if (!blendShapes.empty())
+    {
+      fn(blendShapeHeader);
+      for (auto& ranges : blendShapes)
+      {
+        for (auto& r : ranges)
+        {
+          fn(r);
+        }
+      }
+    }
+  }
 
-    offset += length;
-    WriteBuffer<Vector3>("positions", offset, mesh->m_Positions.size(), outDli, length);
+  ///@return The chunks that the data is made up of, in order: each buffer -
+  /// the interleaved vertices as one - then the blend shape header and each
+  /// blend shape buffer; the last of these takes the factor that follows it,
+  /// which is found by its position.
+  std::vector<PayloadChunk> GetChunks() const
+  {
+    std::vector<PayloadChunk> chunks;
+    for (auto& r : buffers)
+    {
+      if (r.stride == 0)
+      {
+        chunks.push_back({ r.offset, r.length, true });
+      }
+    }
 
-    outBin.write((char*) mesh->m_Positions.data(), length);
+    if (vertices.length > 0)
+    {
+      chunks.push_back({ vertices.offset, vertices.length, true });
+    }
 
-    if (mesh->m_Normals.size())
+    for (auto& r : lods)
     {
-      offset += length;
-      WriteBuffer<Vector3>("normals", offset, mesh->m_Normals.size(), outDli, length);
+      chunks.push_back({ r.offset, r.length, true });
+    }
 
-      outBin.write((char*) mesh->m_Normals.data(), length);
+    if (!blendShapes.empty())
+    {
+      chunks.push_back({ blendShapeHeader.offset, blendShapeHeader.length, false });
+      for (auto& ranges : blendShapes)
+      {
+        for (auto& r : ranges)
+        {
+          chunks.push_back({ r.offset, r.length, false });
+        }
+      }
+      chunks.back().length = static_cast<unsigned int>(data.size()) - chunks.back().offset;
     }
 
-    if (mesh->m_Textures.size())
+    std::stable_sort(chunks.begin(), chunks.end(), [](const PayloadChunk& a, const PayloadChunk& b) {
+      return a.offset < b.offset;
+    });
+    return chunks;
+  }
+
+  ///@brief Registers a buffer of @a length bytes into @a ranges.
+  ///@return The memory to encode the buffer into.
+  char* Allocate(const char* name, unsigned int length, std::vector<BufferRange>& ranges)
+  {
+    const unsigned int offset = data.size();
+    ranges.push_back({ name, offset, length });
+    data.resize(offset + length);
+    return data.data() + offset;
+  }
+
+  void Append(const char* name, const void* source, unsigned int length, std::vector<BufferRange>& ranges)
+  {
+    char* target = Allocate(name, length, ranges);
+    if (length > 0)
     {
-      offset += length;
-      WriteBuffer<Vector2>("textures", offset, mesh->m_Textures.size(), outDli, length);
+      memcpy(target, source, length);
+    }
+  }
+};
+
+///@brief Encodes the deltas of the given blend shape @a values from @a originals,
+/// translated by 0.5 (after scaling by @a scale), in order to make all values
+/// positive, into @a target.
+void EncodeBlendShapeDeltas(const VertexArray<Vector3>& originals, const std::vector<Vector3>& values,
+  float scale, bool clamp, char* target)
+{
+  for (unsigned int index = 0u; index < originals.size(); ++index)
+  {
+    Vector3 delta = values[index] - originals[index];
 
-      outBin.write((char*) mesh->m_Textures.data(), length);
+    delta.x = (delta.x * scale) + 0.5f;
+    delta.y = (delta.y * scale) + 0.5f;
+    delta.z = (delta.z * scale) + 0.5f;
+
+    if (clamp)
+    {
+      delta.x = Util::clamp(delta.x, 0.f, 1.f);
+      delta.y = Util::clamp(delta.y, 0.f, 1.f);
+      delta.z = Util::clamp(delta.z, 0.f, 1.f);
     }
 
-    if (mesh->m_Tangents.size())
+    memcpy(target, delta.data, sizeof(Vector3));
+    target += sizeof(Vector3);
+  }
+}
+
+///@brief Encodes @a indices as 32 bits if @a wide, otherwise 16 bits, into @a ranges.
+void EncodeIndices(const std::vector<uint32_t>& indices, bool wide, MeshPayload& payload,
+  std::vector<BufferRange>& ranges)
+{
+  if (wide)
+  {
+    payload.Append("indices", indices.data(), indices.size() * sizeof(uint32_t), ranges);
+  }
+  else
+  {
+    // Narrow the indices a block at a time, in a loop that the compiler may
+    // vectorize, and copy each block into place as a whole.
+    char* target = payload.Allocate("indices", indices.size() * sizeof(uint16_t), ranges);
+    uint16_t block[1024];
+    const size_t blockSize = sizeof(block) / sizeof(block[0]);
+    for (size_t i = 0; i < indices.size(); i += blockSize)
     {
-      offset += length;
-      WriteBuffer<Vector3>("tangents", offset, mesh->m_Tangents.size(), outDli, length);
+      const size_t count = std::min(blockSize, indices.size() - i);
+      const uint32_t* source = indices.data() + i;
+      for (size_t j = 0; j < count; ++j)
+      {
+        block[j] = static_cast<uint16_t>(source[j]);
+      }
+      memcpy(target, block, count * sizeof(uint16_t));
+      target += count * sizeof(uint16_t);
+    }
+  }
+}
 
-      outBin.write((char*) mesh->m_Tangents.data(), length);
+///@brief Encodes the indices of @a mesh, and those of its levels of detail, in
+/// the narrowest type that they all fit.
+void EncodeIndices(const Mesh& mesh, MeshPayload& payload)
+{
+  auto& indices = mesh.m_Indices;
+  const bool wide = !indices.empty() &&
+    *std::max_element(indices.begin(), indices.end()) > std::numeric_limits<uint16_t>::max();
+  if (wide)
+  {
+    payload.flags |= U32_INDICES;
+  }
+  EncodeIndices(indices, wide, payload, payload.buffers);
+}
+
+///@brief Encodes the @a numVertices values of @a numComponents floats each at
+/// @a values - unit vectors, for octahedral encodings - as @a encoding. If
+/// @a constants is provided, and all values are the same, the value is added
+/// to it instead.
+void EncodeAttribute(const char* name, const float* values, unsigned int numVertices, unsigned int numComponents,
+  VertexEncoding::Type encoding, MeshPayload& payload, std::vector<ConstantAttribute>* constants = nullptr)
+{
+  if (constants && numVertices > 0)
+  {
+    const size_t elementSize = numComponents * sizeof(float);
+    const float* value = values + numComponents;
+    const float* end = values + numVertices * numComponents;
+    while (value != end && memcmp(value, values, elementSize) == 0)
+    {
+      value += numComponents;
     }
 
-    // write weights
-    if (mesh->IsSkinned())
+    if (value == end)
     {
-      offset += length;
-      WriteBuffer<Vector4>("joints0", offset, mesh->m_Joints0.size(), outDli, length);
+      constants->push_back({ name, numComponents, {} });
+      std::copy(values, values + numComponents, constants->back().value);
+      return;
+    }
+  }
+
+  const unsigned int numValues = numVertices * numComponents;
+  float error = 0.f;
+  switch (encoding)
+  {
+  case VertexEncoding::UNORM16:
+  {
+    char* target = payload.Allocate(name, numValues * sizeof(uint16_t), payload.buffers);
+    error = EncodeUnorm16(values, numVertices, numComponents, payload.buffers.back().quantization, target);
+    break;
+  }
+  case VertexEncoding::HALF:
+    error = EncodeHalf(values, numValues, payload.Allocate(name, numValues * sizeof(uint16_t), payload.buffers));
+    break;
+  case VertexEncoding::OCT16:
+  case VertexEncoding::OCT8:
+  {
+    const unsigned int bits = encoding == VertexEncoding::OCT16 ? 16 : 8;
+    error = EncodeOctahedral(reinterpret_cast<const Vector3*>(values), numVertices, bits,
+      payload.Allocate(name, numVertices * 2 * bits / 8, payload.buffers));
+    break;
+  }
+  default:
+    payload.Append(name, values, numValues * sizeof(float), payload.buffers);
+    return;
+  }
 
-      outBin.write(reinterpret_cast<const char*>(mesh->m_Joints0.data()), length);
+  payload.buffers.back().encoding = encoding;
+  payload.errors.push_back({ name, encoding, error });
+}
 
-      offset += length;
-      WriteBuffer<Vector4>("weights0", offset, mesh->m_Weights0.size(), outDli, length);
+///@brief Interleaves the buffers of @a attributes, of @a numVertices elements
+/// each, into a single one in @a payload, where each of them is aligned to 4
+/// bytes, and so is the stride.
+void InterleaveAttributes(const MeshPayload& attributes, unsigned int numVertices, MeshPayload& payload)
+{
+  const unsigned int alignment = 4;
+  std::vector<unsigned int> offsets;
+  unsigned int stride = 0;
+  for (auto& r : attributes.buffers)
+  {
+    offsets.push_back(stride);
+    stride += (r.length / numVertices + alignment - 1) / alignment * alignment;
+  }
 
-      outBin.write(reinterpret_cast<const char*>(mesh->m_Weights0.data()), length);
+  std::vector<BufferRange> vertices;
+  char* target = payload.Allocate("vertices", numVertices * stride, vertices);
+  payload.vertices = vertices.front();
+  payload.vertices.stride = stride;
 
-      outDli.WriteValue("skeleton", scene->FindSkeletonId(mesh->m_Skeleton));
+  auto iOffset = offsets.begin();
+  for (auto& r : attributes.buffers)
+  {
+    const unsigned int elementSize = r.length / numVertices;
+    const char* source = attributes.data.data() + r.offset;
+    for (char* element = target + *iOffset, *end = element + numVertices * stride; element != end; element += stride)
+    {
+      memcpy(element, source, elementSize);
+      source += elementSize;
     }
 
-  if(!mesh->m_BlendShapes.empty())
+    payload.buffers.push_back(r);
+    payload.buffers.back().offset = payload.vertices.offset + *iOffset;
+    payload.buffers.back().stride = stride;
+    ++iOffset;
+  }
+  payload.errors.insert(payload.errors.end(), attributes.errors.begin(), attributes.errors.end());
+}
+
+///@return The greatest size of the payload of @a mesh, but for its levels of
+/// detail, which is when its attributes are 32 bit floats.
+size_t EstimatePayloadSize(const Mesh& mesh)
+{
+  const size_t numberOfVertices = mesh.m_Positions.size();
+  const size_t vertexSize = sizeof(Vector3) * 3 + sizeof(Vector2) + (mesh.IsSkinned() ? sizeof(Vector4) * 2 : 0);
+  return mesh.m_Indices.size() * sizeof(uint32_t) + numberOfVertices * vertexSize +
+    mesh.m_BlendShapes.size() * numberOfVertices * sizeof(Vector3) * 3 + sizeof(BlendShapeHeader) + sizeof(float);
+}
+
+void EncodeMesh(const Mesh& mesh, const SaveOptions& options, MeshPayload& payload)
+{
+  const unsigned int numberOfVertices = mesh.m_Positions.size();
+  payload.data.reserve(EstimatePayloadSize(mesh));
+
+  EncodeIndices(mesh, payload);
+
+  // Interleaved attributes are encoded separately first, then copied into place.
+  const bool interleave = options.interleaved && numberOfVertices > 0;
+  MeshPayload interleaved;
+  MeshPayload& attributes = interleave ? interleaved : payload;
+  EncodeAttribute("positions", reinterpret_cast<const float*>(mesh.m_Positions.data()), numberOfVertices, 3,
+    options.positionEncoding, options.separatePositions ? payload : attributes);
+
+  // The positions are never constant, but for degenerate meshes; the rest may
+  // well be, i.e. the default texture coordinates and tangents of LoadScene().
+  auto constants = options.constantAttributes ? &payload.constants : nullptr;
+  if (mesh.m_Normals.size())
   {
-    offset += length;
-    SaveBlendShapeHeader(mesh->m_BlendShapeHeader, outDli, outBin, offset, length);
+    EncodeAttribute("normals", reinterpret_cast<const float*>(mesh.m_Normals.data()), mesh.m_Normals.size(), 3,
+      options.normalEncoding, attributes, constants);
+  }
 
-    std::vector<std::vector<Vector3>> positions;
-    positions.resize(mesh->m_BlendShapes.size());
+  if (mesh.m_Textures.size())
+  {
+    EncodeAttribute("textures", reinterpret_cast<const float*>(mesh.m_Textures.data()), mesh.m_Textures.size(), 2,
+      options.textureEncoding, attributes, constants);
+  }
 
-    outDli.WriteArray("blendShapes");
+  if (mesh.m_Tangents.size())
+  {
+    EncodeAttribute("tangents", reinterpret_cast<const float*>(mesh.m_Tangents.data()), mesh.m_Tangents.size(), 3,
+      options.normalEncoding, attributes, constants);
+  }
+
+  // write weights
+  if (mesh.IsSkinned())
+  {
+    EncodeAttribute("joints0", reinterpret_cast<const float*>(mesh.m_Joints0.data()), mesh.m_Joints0.size(), 4,
+      VertexEncoding::FLOAT32, attributes, constants);
+    EncodeAttribute("weights0", reinterpret_cast<const float*>(mesh.m_Weights0.data()), mesh.m_Weights0.size(), 4,
+      VertexEncoding::FLOAT32, attributes, constants);
+  }
 
-    const unsigned int numberOfVertices = mesh->m_Positions.size();
-    float maxDistance = 0.f;
+  if (interleave && !interleaved.buffers.empty())
+  {
+    InterleaveAttributes(interleaved, numberOfVertices, payload);
+  }
+
+  for (auto& lod : mesh.m_Lods)
+  {
+    EncodeIndices(lod.m_Indices, (payload.flags & U32_INDICES) != 0, payload, payload.lods);
+  }
 
-    uint32_t blendShapeIndex = 0u;
-    for (auto blendShape : mesh->m_BlendShapes)
+  if (mesh.m_BlendShapes.empty())
+  {
+    return;
+  }
+
+  std::vector<BufferRange> header;
+  char* headerData = payload.Allocate("blendShapeHeader", sizeof(mesh.m_BlendShapeHeader.width) +
+    sizeof(mesh.m_BlendShapeHeader.height), header);
+  memcpy(headerData, &mesh.m_BlendShapeHeader.width, sizeof(mesh.m_BlendShapeHeader.width));
+  memcpy(headerData + sizeof(mesh.m_BlendShapeHeader.width), &mesh.m_BlendShapeHeader.height,
+    sizeof(mesh.m_BlendShapeHeader.height));
+  payload.blendShapeHeader = header.front();
+
+  // Find the max distance to normalize the position deltas.
+  float maxDistance = 0.f;
+  for (auto& blendShape : mesh.m_BlendShapes)
+  {
+    if (!blendShape.m_Positions.empty() && (numberOfVertices == blendShape.m_Positions.size()))
     {
-      if (!blendShape.m_Positions.empty() && (numberOfVertices == blendShape.m_Positions.size()))
+      for (unsigned int index = 0u; index < numberOfVertices; ++index)
       {
-        // Calculate the difference with the original mesh.
-        // Find the max distance to normalize the deltas.
-        std::vector<Vector3>& positionDeltas = positions[blendShapeIndex++];
-        positionDeltas.resize(numberOfVertices);
-        for (unsigned int index = 0u; index < numberOfVertices; ++index)
-        {
-          Vector3& delta = positionDeltas[index];
-          const Vector3& originalValue = mesh->m_Positions[index];
-          const Vector3& blendShapeValue = blendShape.m_Positions[index];
-          delta = blendShapeValue - originalValue;
-
-          maxDistance = std::max(maxDistance, delta.squareMagnitude());
-        }
+        const Vector3 delta = blendShape.m_Positions[index] - mesh.m_Positions[index];
+        maxDistance = std::max(maxDistance, delta.squareMagnitude());
       }
     }
+  }
+
+  const float normalizeFactor = (fabsf(maxDistance) < Util::EPSILON) ? 1.f : (0.5f / sqrtf(maxDistance));
+  const float unnormalizeFactor = 1.f / normalizeFactor;
 
-    const float normalizeFactor = (fabsf(maxDistance) < Util::EPSILON) ? 1.f : (0.5f / sqrtf(maxDistance));
-    const float unnormalizeFactor = 1.f / normalizeFactor;
+  const unsigned int bufferSize = sizeof(Vector3) * numberOfVertices;
+  payload.blendShapes.resize(mesh.m_BlendShapes.size());
+  auto iRanges = payload.blendShapes.begin();
+  for (auto& blendShape : mesh.m_BlendShapes)
+  {
+    auto& ranges = *iRanges;
+    ++iRanges;
+    if (!blendShape.m_Positions.empty() && (numberOfVertices == blendShape.m_Positions.size()))
+    {
+      // Normalize all the deltas and translate to a possitive value.
+      // Deltas are going to be passed to the shader in a color texture
+      // whose values that are less than zero are clamped.
+      EncodeBlendShapeDeltas(mesh.m_Positions, blendShape.m_Positions, normalizeFactor, true,
+        payload.Allocate("positions", bufferSize, ranges));
+    }
+
+    if (!blendShape.m_Normals.empty() && (numberOfVertices == blendShape.m_Normals.size()))
+    {
+      EncodeBlendShapeDeltas(mesh.m_Normals, blendShape.m_Normals, 0.5f, false,
+        payload.Allocate("normals", bufferSize, ranges));
+    }
+
+    if (!blendShape.m_Tangents.empty() && (numberOfVertices == blendShape.m_Tangents.size()))
+    {
+      EncodeBlendShapeDeltas(mesh.m_Tangents, blendShape.m_Tangents, 0.5f, false,
+        payload.Allocate("tangents", bufferSize, ranges));
+    }
+  }
+
+  // Write the unnormalize factor. It isn't referenced by a buffer; it follows the
+  // last one.
+  const unsigned int offset = payload.data.size();
+  payload.data.resize(offset + sizeof(float));
+  memcpy(payload.data.data() + offset, &unnormalizeFactor, sizeof(float));
+}
+
+void WriteBuffers(const std::vector<BufferRange>& ranges, unsigned int baseOffset, JsonWriter& writer)
+{
+  for (auto& r : ranges)
+  {
+    if (r.encoding == VertexEncoding::FLOAT32 && r.stride == 0)
+    {
+      WriteBufferInternal(r.name, baseOffset + r.offset, r.length, writer);
+      continue;
+    }
 
-    blendShapeIndex = 0u;
-    for (auto blendShape : mesh->m_BlendShapes)
+    writer.WriteObject(r.name, true);
+    writer.WriteValue("byteOffset", baseOffset + r.offset);
+    writer.WriteValue("byteLength", r.length);
+    if (r.stride != 0)
+    {
+      writer.WriteValue("byteStride", r.stride);
+    }
+
+    if (r.encoding == VertexEncoding::FLOAT32)
+    {
+      writer.CloseScope();
+      continue;
+    }
+
+    writer.WriteValue("encoding", VertexEncoding::GetName(r.encoding));
+    if (r.quantization.numComponents > 0)
+    {
+      writer.WriteArray("offset", true);
+      WriteArrayData(r.quantization.offset, r.quantization.numComponents, writer);
+      writer.CloseScope();
+      writer.WriteArray("scale", true);
+      WriteArrayData(r.quantization.scale, r.quantization.numComponents, writer);
+      writer.CloseScope();
+    }
+    writer.CloseScope();
+  }
+}
+
+void WriteConstants(const std::vector<ConstantAttribute>& constants, JsonWriter& writer)
+{
+  for (auto& c : constants)
+  {
+    writer.WriteObject(c.name, true);
+    writer.WriteArray("value", true);
+    WriteArrayData(c.value, c.numComponents, writer);
+    writer.CloseScope();
+    writer.CloseScope();
+  }
+}
+
+void WriteMesh(Scene3D* scene, const Mesh& mesh, const MeshPayload& payload, unsigned int baseOffset,
+  const std::string& fileNameBin, JsonWriter& outDli)
+{
+  outDli.WriteObject(nullptr);
+  unsigned int attributes = 0;
+  attributes |= (mesh.m_Indices.size() > 0) ? 1 : 0;
+  attributes |= (mesh.m_Positions.size() > 0) ? 2 : 0;
+  attributes |= (mesh.m_Normals.size() > 0) ? 4 : 0;
+  attributes |= (mesh.m_Textures.size() > 0) ? 8 : 0;
+  attributes |= (mesh.m_Tangents.size() > 0) ? 16 : 0;
+  // NOTE: bit 5 (note the zero-based index) used to be for bitangents.
+  attributes |= (mesh.m_Joints0.size() > 0) ? 64 : 0;
+  attributes |= (mesh.m_Weights0.size() > 0) ? 128 : 0;
+
+  outDli.WriteValue("uri", fileNameBin.c_str());
+  outDli.WriteValue("attributes", attributes);
+  outDli.WriteValue("primitive", "TRIANGLES");
+  if (payload.flags != 0)
+  {
+    outDli.WriteValue("flags", payload.flags);
+  }
+
+  if (payload.vertices.length > 0)
+  {
+    WriteBuffers({ payload.vertices }, baseOffset, outDli);
+  }
+  WriteBuffers(payload.buffers, baseOffset, outDli);
+  WriteConstants(payload.constants, outDli);
+
+  if (!mesh.m_Lods.empty())
+  {
+    outDli.WriteArray("lods");
+    auto iRange = payload.lods.begin();
+    for (auto& lod : mesh.m_Lods)
+    {
+      outDli.WriteObject(nullptr, true);
+      WriteBuffers({ *iRange }, baseOffset, outDli);
+      outDli.WriteValue("error", lod.m_Error);
+      outDli.CloseScope();
+      ++iRange;
+    }
+    outDli.CloseScope();
+  }
+
+  if (mesh.IsSkinned())
+  {
+    outDli.WriteValue("skeleton", scene->FindSkeletonId(mesh.m_Skeleton));
+  }
+
+  if (!mesh.m_BlendShapes.empty())
+  {
+    outDli.WriteObject("blendShapeHeader", true);
+    outDli.WriteValue("version", BLEND_SHAPE_VERSION);
+    outDli.WriteValue("byteOffset", baseOffset + payload.blendShapeHeader.offset);
+    outDli.WriteValue("byteLength", payload.blendShapeHeader.length);
+    outDli.CloseScope();
+
+    outDli.WriteArray("blendShapes");
+    auto iRanges = payload.blendShapes.begin();
+    for (auto& blendShape : mesh.m_BlendShapes)
     {
       outDli.WriteObject(nullptr);
       outDli.WriteValue("name", blendShape.m_Name.c_str());
       outDli.WriteValue("weight", blendShape.m_Weight);
+      WriteBuffers(*iRanges, baseOffset, outDli);
+      ++iRanges;
+      outDli.CloseScope();
+    }
+    outDli.CloseScope();
+  }
 
-      std::vector<Vector3>& positionDeltas = positions[blendShapeIndex++];
-      if (!positionDeltas.empty() && (numberOfVertices == positionDeltas.size()))
-      {
-        // Normalize all the deltas and translate to a possitive value.
-        // Deltas are going to be passed to the shader in a color texture
-        // whose values that are less than zero are clamped.
+  outDli.CloseScope();
+}
 
-        const unsigned int bufferSize = sizeof(Vector3) * numberOfVertices;
-        std::vector<unsigned char> positionDeltasBuffer(bufferSize);
-        for (unsigned int index = 0u, bufferIndex = 0u; index < numberOfVertices; ++index)
-        {
-          Vector3 delta = positionDeltas[index];
-          delta.x = Util::clamp(((delta.x * normalizeFactor) + 0.5f), 0.f, 1.f);
-          delta.y = Util::clamp(((delta.y * normalizeFactor) + 0.5f), 0.f, 1.f);
-          delta.z = Util::clamp(((delta.z * normalizeFactor) + 0.5f), 0.f, 1.f);
+///@brief Places the chunks of the payloads of meshes into the .bin, one after
+/// the other, and rebases their buffers onto them. Chunks identical to one
+/// placed earlier may reference it, rather than be written; the rest are
+/// padded to the alignment. Refer to SaveOptions::shareBuffers and
+/// bufferAlignment. Chunks are matched by two independent hashes of their data,
+/// so that only those are kept, rather than the data of every chunk placed.
+class BinLayout
+{
+public:
+  explicit BinLayout(const SaveOptions& options)
+  : m_Alignment(std::max(options.bufferAlignment, 1u)),
+    m_Share(options.shareBuffers)
+  {}
 
-          memcpy(positionDeltasBuffer.data()+bufferIndex, delta.data, sizeof(Vector3));
-          bufferIndex += sizeof(Vector3);
+  ///@brief Places the chunks of @a payload after the ones placed so far, and
+  /// rebases its buffers onto them.
+  ///@return The chunks to write, in order, with the padding before each.
+  std::vector<PayloadChunk> Place(MeshPayload& payload)
+  {
+    const auto chunks = payload.GetChunks();
+    std::vector<PayloadChunk> written;
+    std::vector<unsigned int> chunkOffsets;
+    chunkOffsets.reserve(chunks.size());
+    for (auto& c : chunks)
+    {
+      const char* data = payload.data.data() + c.offset;
+      if (m_Share && c.shareable && c.length > 0)
+      {
+        const uint64_t hash = Hash64(data, c.length);
+        const uint64_t check = Hash64(data, c.length, CHECK_SEED);
+        auto range = m_Placed.equal_range(hash);
+        auto iFind = std::find_if(range.first, range.second, [check, &c](const decltype(m_Placed)::value_type& p) {
+          return p.second.length == c.length && p.second.check == check;
+        });
+        if (iFind != range.second)
+        {
+          chunkOffsets.push_back(iFind->second.offset);
+          m_NumBytesShared += c.length;
+          continue;
         }
-
-        offset += length;
-        WriteBuffer<char>("positions", offset, bufferSize, outDli, length);
-        outBin.write(reinterpret_cast<char*>(positionDeltasBuffer.data()), length);
+        m_Placed.emplace(hash, PlacedChunk{ check, c.length, m_Offset });
       }
 
-      if (!blendShape.m_Normals.empty() && (numberOfVertices == blendShape.m_Normals.size()))
+      const unsigned int padding = (m_Alignment - m_Offset % m_Alignment) % m_Alignment;
+      m_Offset += padding;
+      m_NumBytesPadding += padding;
+
+      chunkOffsets.push_back(m_Offset);
+      written.push_back(c);
+      written.back().padding = padding;
+      m_Offset += c.length;
+    }
+
+    payload.ForEachBuffer([&chunks, &chunkOffsets](BufferRange& r) {
+      for (size_t i = 0; i < chunks.size(); ++i)
       {
-        // Calculate the difference with the original mesh, and translate to make all values positive.
-        const unsigned int bufferSize = sizeof(Vector3) * numberOfVertices;
-        std::vector<unsigned char> normalDeltasBuffer(bufferSize);
-        for (unsigned int index = 0u, bufferIndex = 0u; index < numberOfVertices; ++index)
+        auto& c = chunks[i];
+        if (r.offset >= c.offset && r.offset + r.length <= c.offset + c.length)
         {
-          const Vector3& originalValue = mesh->m_Normals[index];
-          const Vector3& blendShapeValue = blendShape.m_Normals[index];
-          Vector3 delta = blendShapeValue - originalValue;
+          r.offset = chunkOffsets[i] + (r.offset - c.offset);
+          break;
+        }
+      }
+    });
+    return written;
+  }
+
+  size_t GetNumBytesShared() const
+  {
+    return m_NumBytesShared;
+  }
+
+  size_t GetNumBytesPadding() const
+  {
+    return m_NumBytesPadding;
+  }
 
-          delta.x *= 0.5f;
-          delta.y *= 0.5f;
-          delta.z *= 0.5f;
+private:
+  // The seed of the hash that confirms matches of the first one.
+  static const uint64_t CHECK_SEED = 0x9e3779b97f4a7c15;
 
-          delta.x += 0.5f;
-          delta.y += 0.5f;
-          delta.z += 0.5f;
+  struct PlacedChunk
+  {
+    uint64_t check;   // the hash of the data with CHECK_SEED.
+    unsigned int length;
+    unsigned int offset;
+  };
+
+  const unsigned int m_Alignment;
+  const bool m_Share;
+  unsigned int m_Offset = 0;
+  size_t m_NumBytesShared = 0;
+  size_t m_NumBytesPadding = 0;
+  std::unordered_multimap<uint64_t, PlacedChunk> m_Placed;
+};
 
-          memcpy(normalDeltasBuffer.data()+bufferIndex, delta.data, sizeof(Vector3));
-          bufferIndex += sizeof(Vector3);
-        }
+void SaveMeshes(Scene3D *scene, JsonWriter& outDli, ostream &outBin,
+    std::string fileNameBin, WorkerPool* workers, const SaveOptions& options)
+{
+  // Encode the binary data of the meshes first; this is where the bulk of the
+  // work is, and it's independent for each mesh. Without a memory budget, all
+  // of them are encoded at once, otherwise in batches - of at least one mesh -
+  // whose payloads fit the budget, each of them written before the next one.
+  // The place of each payload in the .bin only depends on the ones before it,
+  // so the output is the same either way.
+  const unsigned int numMeshes = scene->GetNumMeshes();
+  const size_t budget = options.memoryBudget > 0 ? options.memoryBudget : std::numeric_limits<size_t>::max();
+  BinLayout layout(options);
+  for (unsigned int first = 0, end = 0; first < numMeshes; first = end)
+  {
+    size_t batchSize = EstimatePayloadSize(*scene->GetMesh(end));
+    ++end;
+    while (end < numMeshes)
+    {
+      const size_t size = EstimatePayloadSize(*scene->GetMesh(end));
+      if (batchSize + size > budget)
+      {
+        break;
+      }
+      batchSize += size;
+      ++end;
+    }
 
-        offset += length;
-        WriteBuffer<char>("normals", offset, bufferSize, outDli, length);
-        outBin.write(reinterpret_cast<char*>(normalDeltasBuffer.data()), length);
+    std::vector<MeshPayload> payloads(end - first);
+    WorkerPool::Execute(workers, payloads.size(), [scene, &options, &payloads, first](unsigned int i) {
+      EncodeMesh(*scene->GetMesh(first + i), options, payloads[i]);
+    });
+
+    for (unsigned int m = first; m < end; ++m)
+    {
+      auto& errors = payloads[m - first].errors;
+      if (errors.empty())
+      {
+        continue;
       }
 
-      if (!blendShape.m_Tangents.empty() && (numberOfVertices == blendShape.m_Tangents.size()))
+      cout << "Mesh " << m << ": greatest encoding error:";
+      for (auto& e : errors)
       {
-        // Calculate the difference with the original mesh, and translate to make all values positive.
-        const unsigned int bufferSize = sizeof(Vector3) * numberOfVertices;
-        std::vector<unsigned char> tangentDeltasBuffer(bufferSize);
-        for (unsigned int index = 0u, bufferIndex = 0u; index < numberOfVertices; ++index)
+        cout << (&e == &errors.front() ? " " : ", ") << e.name << " (" << VertexEncoding::GetName(e.encoding) <<
+          ") " << e.error;
+        if (e.encoding == VertexEncoding::OCT16 || e.encoding == VertexEncoding::OCT8)
         {
-          const Vector3& originalValue = mesh->m_Normals[index];
-          const Vector3& blendShapeValue = blendShape.m_Normals[index];
-          Vector3 delta = blendShapeValue - originalValue;
-
-          delta.x *= 0.5f;
-          delta.y *= 0.5f;
-          delta.z *= 0.5f;
+          cout << " degrees";
+        }
+      }
+      cout << endl;
+    }
 
-          delta.x += 0.5f;
-          delta.y += 0.5f;
-          delta.z += 0.5f;
+    for (unsigned int m = first; m < end; ++m)
+    {
+      auto& payload = payloads[m - first];
+      const auto written = layout.Place(payload);
+      WriteMesh(scene, *scene->GetMesh(m), payload, 0, fileNameBin, outDli);
 
-          memcpy(tangentDeltasBuffer.data()+bufferIndex, delta.data, sizeof(Vector3));
-          bufferIndex += sizeof(Vector3);
+      for (auto& c : written)
+      {
+        for (unsigned int i = 0; i < c.padding; ++i)
+        {
+          outBin.put(0);
         }
+        outBin.write(payload.data.data() + c.offset, c.length);
+      }
+    }
 
-        offset += length;
-        WriteBuffer<char>("tangents", offset, bufferSize, outDli, length);
-        outBin.write(reinterpret_cast<char*>(tangentDeltasBuffer.data()), length);
+    if (options.memoryBudget > 0)
+    {
+      // Release the data of the meshes that have been written, and the payloads.
+      for (unsigned int m = first; m < end; ++m)
+      {
+        *scene->GetMesh(m) = Mesh();
       }
-      outDli.CloseScope();
     }
+  }
 
-    // Write the unnormalize factor.
-    outBin.write(reinterpret_cast<const char*>(&unnormalizeFactor), sizeof(float));
-    length += sizeof(float);
-    outDli.CloseScope();
+  if (layout.GetNumBytesShared() > 0)
+  {
+    cout << "Shared " << layout.GetNumBytesShared() << " bytes of identical buffers." << endl;
   }
-    outDli.CloseScope();
+
+  if (options.bufferAlignment > 1)
+  {
+    cout << "Aligned buffers to " << options.bufferAlignment << " bytes, with " << layout.GetNumBytesPadding() <<
+      " bytes of padding." << endl;
   }
 }
 
@@ -500,7 +1140,7 @@ void SaveSkeletons(Scene3D* scene, JsonWriter& outDli)
     {
         outDli.WriteObject(nullptr, true);
 
-        auto nodeName = Node3D::MakeValidName(scene->GetSkeletonRoot(i)->m_Name);
+        auto& nodeName = scene->GetValidName(scene->GetSkeletonRoot(i)->m_NameId);
         outDli.WriteValue("node", nodeName.c_str());
         outDli.CloseScope();
     }
@@ -617,11 +1257,12 @@ void SaveAnimations(Scene3D *scene, JsonWriter& outDli, std::set<std::string>& a
     std::string currentNodeName;
     for (unsigned int n = 0; n < animation->AnimNodesList.size(); n++)
     {
-      NodeAnimation3D nodeAnim = animation->AnimNodesList[n];
+      const NodeAnimation3D& nodeAnim = animation->AnimNodesList[n];
+      const std::string& nodeName = scene->GetValidName(nodeAnim.NodeNameId);
 
-      WriteNodeKeyframes("orientation", outDli, animation, n, nodeAnim.Rotations, 4 * sizeof(float));
-      WriteNodeKeyframes("position", outDli, animation, n, nodeAnim.Positions, 3 * sizeof(float));
-      WriteNodeKeyframes("scale", outDli, animation, n, nodeAnim.Scales, 3 * sizeof(float));
+      WriteNodeKeyframes("orientation", outDli, animation, nodeName, nodeAnim.Rotations, 4 * sizeof(float));
+      WriteNodeKeyframes("position", outDli, animation, nodeName, nodeAnim.Positions, 3 * sizeof(float));
+      WriteNodeKeyframes("scale", outDli, animation, nodeName, nodeAnim.Scales, 3 * sizeof(float));
       if (!nodeAnim.Weights.empty())
       {
         if (currentNodeName != nodeAnim.NodeName)
@@ -631,7 +1272,7 @@ void SaveAnimations(Scene3D *scene, JsonWriter& outDli, std::set<std::string>& a
         }
         char propertyName[256];
         sprintf(propertyName, "uBlendShapeWeight[%d]", weightIndex);;
-        WriteNodeKeyframes(propertyName, outDli, animation, n, nodeAnim.Weights, sizeof(float));
+        WriteNodeKeyframes(propertyName, outDli, animation, nodeName, nodeAnim.Weights, sizeof(float));
         ++weightIndex;
       }
     }
@@ -765,9 +1406,10 @@ void SaveAnimationsBinary(Scene3D *scene, JsonWriter& outDli, std::string outPat
     for (unsigned int n = 0; n < animation->AnimNodesList.size(); n++)
     {
       const NodeAnimation3D& nodeAnim = animation->AnimNodesList[n];
-      WriteNodeKeyframesBin(animationFilename, "orientation", outDli, osBin, offset, animation, n, nodeAnim.Rotations, 4 * sizeof(float));
-      WriteNodeKeyframesBin(animationFilename, "position", outDli, osBin, offset, animation, n, nodeAnim.Positions, 3 * sizeof(float));
-      WriteNodeKeyframesBin(animationFilename, "scale", outDli, osBin, offset, animation, n, nodeAnim.Scales, 3 * sizeof(float));
+      const std::string& nodeName = scene->GetValidName(nodeAnim.NodeNameId);
+      WriteNodeKeyframesBin(animationFilename, "orientation", outDli, osBin, offset, animation, nodeName, nodeAnim.Rotations, 4 * sizeof(float));
+      WriteNodeKeyframesBin(animationFilename, "position", outDli, osBin, offset, animation, nodeName, nodeAnim.Positions, 3 * sizeof(float));
+      WriteNodeKeyframesBin(animationFilename, "scale", outDli, osBin, offset, animation, nodeName, nodeAnim.Scales, 3 * sizeof(float));
 
       if (!nodeAnim.Weights.empty())
       {
@@ -779,7 +1421,7 @@ void SaveAnimationsBinary(Scene3D *scene, JsonWriter& outDli, std::string outPat
 
         char propertyName[256];
         sprintf(propertyName, "uBlendShapeWeight[%d]", weightIndex);;
-        WriteNodeKeyframesBin(animationFilename, propertyName, outDli, osBin, offset, animation, n, nodeAnim.Weights, sizeof(float));
+        WriteNodeKeyframesBin(animationFilename, propertyName, outDli, osBin, offset, animation, nodeName, nodeAnim.Weights, sizeof(float));
         ++weightIndex;
       }
     }
@@ -791,14 +1433,11 @@ void SaveAnimationsBinary(Scene3D *scene, JsonWriter& outDli, std::string outPat
   }
 }
 
-void WriteNodeKeyframes(const std::string& strProperty, JsonWriter& outDli, Animation3D *animation, int animationidx, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize)
+void WriteNodeKeyframes(const std::string& strProperty, JsonWriter& outDli, Animation3D *animation, const std::string& nodeName, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize)
 {
   if (keyframes.size())
   {
-    const NodeAnimation3D& nodeAnim = animation->AnimNodesList[animationidx];
     outDli.WriteObject(nullptr);
-
-    auto nodeName = Node3D::MakeValidName(nodeAnim.NodeName);
     outDli.WriteValue("node", nodeName.c_str());
     outDli.WriteValue("property", strProperty.c_str());
 
@@ -825,14 +1464,11 @@ void WriteNodeKeyframes(const std::string& strProperty, JsonWriter& outDli, Anim
   }
 }
 
-void WriteNodeKeyframesBin(const std::string& url, const std::string& strProperty, JsonWriter& outDli, std::ostream& osBin, unsigned int& offset, Animation3D *animation, int animationidx, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize)
+void WriteNodeKeyframesBin(const std::string& url, const std::string& strProperty, JsonWriter& outDli, std::ostream& osBin, unsigned int& offset, Animation3D *animation, const std::string& nodeName, const std::vector<NodeKey>& keyframes, unsigned int keyByteSize)
 {
   if (keyframes.size())
   {
-    const NodeAnimation3D& nodeAnim = animation->AnimNodesList[animationidx];
     outDli.WriteObject(nullptr);
-
-    auto nodeName = Node3D::MakeValidName(nodeAnim.NodeName);
     outDli.WriteValue("node", nodeName.c_str());
     outDli.WriteValue("property", strProperty.c_str());
 
@@ -23,17 +23,21 @@ Scene3D::Scene3D()
 
 Scene3D::~Scene3D()
 {
-    for(unsigned int i=0; i < m_nodes.size(); i++)
-    {
-        delete m_nodes[i];
-    }
-    m_nodes.clear();
+}
+
+Node3D* Scene3D::CreateNode(Node3D* parent)
+{
+    return m_nodePool.Create(parent);
 }
 
 void Scene3D::AddNode(Node3D *enode)
 {
     enode->m_Index = m_nodes.size();
     m_nodes.push_back(enode);
+    enode->m_NameId = m_names.Intern(enode->m_Name);
+
+    // Names needn't be unique; as with a linear search, the first node wins.
+    m_nodeNames.emplace(enode->m_Name, enode);
 }
 
 unsigned int Scene3D::GetNumNodes() const
@@ -58,15 +62,15 @@ Node3D *Scene3D::GetNode(unsigned int idx)
 
 Node3D* Scene3D::FindNodeNamed(const std::string& name) const
 {
-  auto iFind = std::find_if(m_nodes.begin(), m_nodes.end(), [&name](const Node3D* n){
-    return n->m_Name == name;
-  });
-  return iFind != m_nodes.end() ? *iFind : nullptr;
+  auto iFind = m_nodeNames.find(name);
+  return iFind != m_nodeNames.end() ? iFind->second : nullptr;
 }
 
-void Scene3D::AddMesh(Mesh* emesh)
+Mesh* Scene3D::AddMesh(Mesh&& emesh)
 {
-  m_meshes.push_back(emesh);
+  Mesh* mesh = m_meshPool.Create(std::move(emesh));
+  m_meshes.push_back(mesh);
+  return mesh;
 }
 
 Mesh* Scene3D::GetMesh(unsigned int idx) const
@@ -74,6 +78,24 @@ Mesh* Scene3D::GetMesh(unsigned int idx) const
   return m_meshes[idx];
 }
 
+void Scene3D::RemoveMeshes(const std::vector<bool>& remove)
+{
+  auto iWrite = m_meshes.begin();
+  for (unsigned int i = 0; i < m_meshes.size(); ++i)
+  {
+    if (remove[i])
+    {
+      *m_meshes[i] = Mesh();
+    }
+    else
+    {
+      *iWrite = m_meshes[i];
+      ++iWrite;
+    }
+  }
+  m_meshes.erase(iWrite, m_meshes.end());
+}
+
 void Scene3D::AddSkeletonRoot(Node3D * node)
 {
     m_skeletonRoots.push_back(node);
@@ -123,6 +145,10 @@ Light* Scene3D::GetLight(unsigned int idx)
 void Scene3D::AddAnimation(Animation3D &eanim)
 {
     m_animations.push_back(eanim);
+    for (auto& nodeAnim : m_animations.back().AnimNodesList)
+    {
+        nodeAnim.NodeNameId = m_names.Intern(nodeAnim.NodeName);
+    }
 }
 
 unsigned int Scene3D::GetNumAnimations() const
@@ -144,3 +170,13 @@ bool Scene3D::HasAnimations()
     }
     return anim;
 }
+
+const std::string& Scene3D::GetValidName(unsigned int nameId) const
+{
+    return m_names.GetValidName(nameId);
+}
+
+unsigned int Scene3D::GetNumAllocations() const
+{
+  return m_nodePool.GetNumBlocks() + m_meshPool.GetNumBlocks();
+}
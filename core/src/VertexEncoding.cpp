@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "VertexEncoding.h"
+#include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+const char* const ENCODING_NAMES[] = { "FLOAT32", "UNORM16", "HALF", "OCT16", "OCT8" };
+
+const float DEGREES_PER_RADIAN = 57.2957795f;
+
+template <typename T>
+void Store(T value, char*& target)
+{
+  memcpy(target, &value, sizeof(value));
+  target += sizeof(value);
+}
+
+///@brief Maps the unit vector @a v onto the octahedron, which is unfolded onto
+/// the [-1, 1] square.
+void ToOctahedron(const Vector3& v, float& x, float& y)
+{
+  const float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+  x = l1 > 0.f ? v.x / l1 : 0.f;
+  y = l1 > 0.f ? v.y / l1 : 0.f;
+  if (v.z < 0.f)
+  {
+    const float fx = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+    y = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+    x = fx;
+  }
+}
+
+Vector3 FromOctahedron(float x, float y)
+{
+  Vector3 v;
+  v.x = x;
+  v.y = y;
+  v.z = 1.f - fabsf(x) - fabsf(y);
+  const float t = std::max(-v.z, 0.f);
+  v.x += v.x >= 0.f ? -t : t;
+  v.y += v.y >= 0.f ? -t : t;
+  v.normalize();
+  return v;
+}
+
+}
+
+const char* VertexEncoding::GetName(Type type)
+{
+  return ENCODING_NAMES[type];
+}
+
+bool VertexEncoding::FromName(const std::string& name, Type& type)
+{
+  std::string upper = name;
+  std::transform(upper.begin(), upper.end(), upper.begin(), [](char c) {
+    return static_cast<char>(toupper(c));
+  });
+
+  for (unsigned int i = 0; i < sizeof(ENCODING_NAMES) / sizeof(ENCODING_NAMES[0]); ++i)
+  {
+    if (upper == ENCODING_NAMES[i])
+    {
+      type = static_cast<Type>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+float EncodeUnorm16(const float* values, size_t count, unsigned int numComponents, VertexQuantization& quantization,
+  char* target)
+{
+  const float max = std::numeric_limits<uint16_t>::max();
+  quantization.numComponents = numComponents;
+  for (unsigned int c = 0; c < numComponents; ++c)
+  {
+    float low = count > 0 ? values[c] : 0.f;
+    float high = low;
+    for (size_t i = 1; i < count; ++i)
+    {
+      low = std::min(low, values[i * numComponents + c]);
+      high = std::max(high, values[i * numComponents + c]);
+    }
+    quantization.offset[c] = low;
+    quantization.scale[c] = high - low;
+  }
+
+  float maxError = 0.f;
+  for (size_t i = 0; i < count; ++i)
+  {
+    for (unsigned int c = 0; c < numComponents; ++c)
+    {
+      const float value = *values++;
+      const float scale = quantization.scale[c];
+      const float n = scale > 0.f ? (value - quantization.offset[c]) / scale : 0.f;
+      const uint16_t q = static_cast<uint16_t>(Util::clamp(n, 0.f, 1.f) * max + .5f);
+      Store(q, target);
+
+      const float decoded = quantization.offset[c] + scale * (q / max);
+      maxError = std::max(maxError, fabsf(decoded - value));
+    }
+  }
+  return maxError;
+}
+
+float EncodeHalf(const float* values, size_t count, char* target)
+{
+  float maxError = 0.f;
+  for (const float* end = values + count; values != end; ++values)
+  {
+    const uint16_t half = FloatToHalf(*values);
+    Store(half, target);
+    maxError = std::max(maxError, fabsf(HalfToFloat(half) - *values));
+  }
+  return maxError;
+}
+
+float EncodeOctahedral(const Vector3* vectors, size_t count, unsigned int bits, char* target)
+{
+  const float max = static_cast<float>((1 << (bits - 1)) - 1);
+  float minCos = 1.f;
+  for (const Vector3* end = vectors + count; vectors != end; ++vectors)
+  {
+    Vector3 v = *vectors;
+    const bool isZero = v.squareMagnitude() < Util::EPSILON * Util::EPSILON;
+    if (!isZero)
+    {
+      v.normalize();
+    }
+
+    float x, y;
+    ToOctahedron(v, x, y);
+
+    // Of the four nearest points on the grid, pick the one which decodes to
+    // the closest direction.
+    const float fx = floorf(x * max);
+    const float fy = floorf(y * max);
+    float bestX = fx;
+    float bestY = fy;
+    float bestCos = -2.f;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+      const float qx = Util::clamp(fx + (i & 1), -max, max);
+      const float qy = Util::clamp(fy + (i >> 1), -max, max);
+      const Vector3 decoded = FromOctahedron(qx / max, qy / max);
+      const float cos = decoded.x * v.x + decoded.y * v.y + decoded.z * v.z;
+      if (cos > bestCos)
+      {
+        bestCos = cos;
+        bestX = qx;
+        bestY = qy;
+      }
+    }
+
+    if (bits == 8)
+    {
+      Store(static_cast<int8_t>(bestX), target);
+      Store(static_cast<int8_t>(bestY), target);
+    }
+    else
+    {
+      Store(static_cast<int16_t>(bestX), target);
+      Store(static_cast<int16_t>(bestY), target);
+    }
+
+    if (!isZero)
+    {
+      minCos = std::min(minCos, bestCos);
+    }
+  }
+  return acosf(Util::clamp(minCos, -1.f, 1.f)) * DEGREES_PER_RADIAN;
+}
+
+uint16_t FloatToHalf(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t magnitude = bits & 0x7fffffff;
+  if (magnitude >= 0x7f800000) // infinity or NaN
+  {
+    return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0);
+  }
+
+  if (magnitude >= 0x477ff000) // rounds to 65520 or more; too great.
+  {
+    return sign | 0x7c00;
+  }
+
+  if (magnitude < 0x38800000) // less than 2^-14; subnormal.
+  {
+    float f;
+    memcpy(&f, &magnitude, sizeof(f));
+    return sign | static_cast<uint16_t>(lrintf(f * 16777216.f)); // 2^24
+  }
+
+  // Rebias the exponent, and round the mantissa to the nearest, or even.
+  uint32_t half = (magnitude - 0x38000000) >> 13;
+  const uint32_t remainder = magnitude & 0x1fff;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+  {
+    ++half;
+  }
+  return sign | static_cast<uint16_t>(half);
+}
+
+float HalfToFloat(uint16_t half)
+{
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  const uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0)
+  {
+    const float f = mantissa / 16777216.f; // 2^24
+    memcpy(&bits, &f, sizeof(bits));
+    bits |= sign;
+  }
+  else if (exponent == 0x1f)
+  {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  }
+  else
+  {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "WorkerPool.h"
+#include <cstdint>
+
+unsigned int WorkerPool::GetDefaultNumThreads()
+{
+  const unsigned int numThreads = std::thread::hardware_concurrency();
+  return numThreads > 0 ? numThreads : 1;
+}
+
+void WorkerPool::Execute(WorkerPool* workers, unsigned int numTasks, const Task& task)
+{
+  if (workers)
+  {
+    workers->Run(numTasks, task);
+  }
+  else
+  {
+    for (unsigned int i = 0; i < numTasks; ++i)
+    {
+      task(i);
+    }
+  }
+}
+
+WorkerPool::WorkerPool(unsigned int numThreads)
+: m_Pending(0),
+  m_Failed(false)
+{
+  if (numThreads == 0)
+  {
+    numThreads = GetDefaultNumThreads();
+  }
+
+  for (unsigned int i = 0; i < numThreads; ++i)
+  {
+    m_Queues.emplace_back(new Queue());
+  }
+
+  // Worker 0 is whoever calls Run().
+  for (unsigned int i = 1; i < numThreads; ++i)
+  {
+    m_Threads.emplace_back(&WorkerPool::WorkerMain, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Quit = true;
+  }
+  m_WakeCondition.notify_all();
+
+  for (auto& t : m_Threads)
+  {
+    t.join();
+  }
+}
+
+unsigned int WorkerPool::GetNumThreads() const
+{
+  return m_Queues.size();
+}
+
+void WorkerPool::Run(unsigned int numTasks, const Task& task)
+{
+  const unsigned int numWorkers = m_Queues.size();
+  if (numWorkers == 1 || numTasks < 2)
+  {
+    for (unsigned int i = 0; i < numTasks; ++i)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  // The task must be visible before any of the indices are; the queue mutexes
+  // take care of that.
+  m_Task = &task;
+  m_Pending = numTasks;
+
+  unsigned int begin = 0;
+  for (unsigned int i = 0; i < numWorkers; ++i)
+  {
+    const unsigned int end = static_cast<unsigned int>((static_cast<uint64_t>(numTasks) * (i + 1)) / numWorkers);
+    Queue& queue = *m_Queues[i];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    for (; begin < end; ++begin)
+    {
+      queue.indices.push_back(begin);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_Generation;
+  }
+  m_WakeCondition.notify_all();
+
+  Work(0);
+
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_DoneCondition.wait(lock, [this]() {
+    return m_Pending == 0;
+  });
+  m_Task = nullptr;
+
+  if (m_Failed)
+  {
+    std::exception_ptr exception;
+    std::swap(exception, m_Exception);
+    m_Failed = false;
+    lock.unlock();
+    std::rethrow_exception(exception);
+  }
+}
+
+void WorkerPool::WorkerMain(unsigned int workerIndex)
+{
+  unsigned int generation = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_WakeCondition.wait(lock, [this, generation]() {
+        return m_Quit || m_Generation != generation;
+      });
+
+      if (m_Quit)
+      {
+        break;
+      }
+      generation = m_Generation;
+    }
+
+    Work(workerIndex);
+  }
+}
+
+void WorkerPool::Work(unsigned int workerIndex)
+{
+  unsigned int index;
+  while (Pop(workerIndex, index) || Steal(workerIndex, index))
+  {
+    // Once a task has failed, the rest are only taken off the queues.
+    if (!m_Failed)
+    {
+      try
+      {
+        (*m_Task)(index);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Failed)
+        {
+          m_Exception = std::current_exception();
+          m_Failed = true;
+        }
+      }
+    }
+
+    if (--m_Pending == 0)
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_DoneCondition.notify_all();
+    }
+  }
+}
+
+bool WorkerPool::Pop(unsigned int workerIndex, unsigned int& outIndex)
+{
+  Queue& queue = *m_Queues[workerIndex];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.indices.empty())
+  {
+    return false;
+  }
+
+  outIndex = queue.indices.front();
+  queue.indices.pop_front();
+  return true;
+}
+
+bool WorkerPool::Steal(unsigned int workerIndex, unsigned int& outIndex)
+{
+  // Take from the back, i.e. the work that the victim would get to last.
+  const unsigned int numWorkers = m_Queues.size();
+  for (unsigned int i = 1; i < numWorkers; ++i)
+  {
+    Queue& queue = *m_Queues[(workerIndex + i) % numWorkers];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.indices.empty())
+    {
+      outIndex = queue.indices.back();
+      queue.indices.pop_back();
+      return true;
+    }
+  }
+  return false;
+}